@@ -0,0 +1,202 @@
+#include "lib/interpreter/interpreter.h"
+#include "lib/lexer/lexer.h"
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <spawn.h>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Every workload is a script in workloads/. The lexing and parsing
+// benchmarks work on its text; the run benchmarks compile it once and time
+// complete runs, each with fresh globals, like a script started from a file.
+
+static std::string load(const std::string& name) {
+    std::ifstream file(std::string(ITMOSCRIPT_WORKLOADS_DIR) + "/" + name + ".is");
+    if (!file) throw std::runtime_error("Cannot open workload " + name);
+    std::ostringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+static std::shared_ptr<const Program> compile(const std::string& source) {
+    std::istringstream input(source);
+    return Program::compile(input);
+}
+
+static void run_once(benchmark::State& state, const Program& program, const Budget* budget = nullptr,
+                     unsigned threads = 0) {
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    if (budget) interpreter.set_budget(*budget);
+    if (threads) interpreter.set_threads(threads);
+    if (!interpreter.run(program)) {
+        state.SkipWithError(output.str().c_str());
+        return;
+    }
+    benchmark::DoNotOptimize(output.str().size());
+}
+
+static void BM_Lex(benchmark::State& state, const std::string& name) {
+    std::string source = load(name);
+    size_t tokens = 0;
+    for (auto _ : state) {
+        Lexer lexer(source);
+        while (lexer.get_next_token().type != TokenType::END) ++tokens;
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * source.size()));
+    state.counters["tokens"] = benchmark::Counter(static_cast<double>(tokens), benchmark::Counter::kIsRate);
+}
+
+static void BM_Parse(benchmark::State& state, const std::string& name) {
+    std::string source = load(name);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(compile(source));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * source.size()));
+}
+
+static void BM_Run(benchmark::State& state, const std::string& name) {
+    auto program = compile(load(name));
+    for (auto _ : state) {
+        run_once(state, *program);
+    }
+}
+
+// Cost of the execution budget checks: every limit set, none reached.
+static void BM_RunWithBudget(benchmark::State& state, const std::string& name) {
+    auto program = compile(load(name));
+    Budget budget;
+    budget.max_steps = 1ull << 40;
+    budget.max_call_depth = 100000;
+    budget.max_alloc_bytes = size_t(1) << 40;
+    budget.timeout = std::chrono::hours(1);
+    for (auto _ : state) {
+        run_once(state, *program, &budget);
+    }
+}
+
+// pmap scaling: the argument is the number of threads.
+static void BM_PmapThreads(benchmark::State& state) {
+    auto program = compile(load("pmap_collatz"));
+    for (auto _ : state) {
+        run_once(state, *program, nullptr, static_cast<unsigned>(state.range(0)));
+    }
+}
+
+// The log the file benchmarks read: $ITMOSCRIPT_BENCH_LOG when set (point it
+// at a multi-GB log for the real thing), otherwise a generated 64 MiB one.
+static std::string bench_log() {
+    if (const char* path = std::getenv("ITMOSCRIPT_BENCH_LOG")) return path;
+
+    static const std::string path = [] {
+        auto file = std::filesystem::temp_directory_path() / "itmoscript_bench.log";
+        constexpr uintmax_t kSize = uintmax_t(64) << 20;
+        std::error_code error;
+        if (std::filesystem::file_size(file, error) == kSize) return file.string();
+
+        std::ofstream log(file, std::ios::binary);
+        const char* levels[] = {"INFO", "INFO", "DEBUG", "WARN", "INFO", "ERROR"};
+        std::string line;
+        for (uintmax_t written = 0, i = 0; written < kSize; written += line.size(), ++i) {
+            line = "2024-05-01T12:" + std::to_string(10 + i % 50) + ":00Z " + levels[i % 6] +
+                   " request " + std::to_string(i) + " served in " + std::to_string(i % 997) + "ms\n";
+            line.resize(std::min<uintmax_t>(line.size(), kSize - written));
+            log << line;
+        }
+        return file.string();
+    }();
+    return path;
+}
+
+// A workload run over the benchmark log, whose path it gets as `path`.
+static void BM_LargeFile(benchmark::State& state, const std::string& name) {
+    std::string path = bench_log();
+    auto program = compile("path = \"" + path + "\"\n" + load(name));
+    for (auto _ : state) {
+        run_once(state, *program);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * std::filesystem::file_size(path)));
+}
+
+// Time to first output inside the process: a fresh interpreter compiles and
+// runs hello.is, as the command-line runner does after startup.
+static void BM_FirstOutput(benchmark::State& state) {
+    std::string source = load("hello");
+    for (auto _ : state) {
+        std::ostringstream output;
+        Interpreter interpreter(output);
+        std::istringstream input(source);
+        interpreter.run(*Program::compile(input));
+        benchmark::DoNotOptimize(output.str().size());
+    }
+}
+
+// Time to first output of the itmoscript binary on hello.is: process start,
+// dynamic loading and static initialisation included.
+static void BM_ColdStart(benchmark::State& state) {
+    std::string script = std::string(ITMOSCRIPT_WORKLOADS_DIR) + "/hello.is";
+    char* argv[] = {const_cast<char*>(ITMOSCRIPT_CLI), script.data(), nullptr};
+
+    for (auto _ : state) {
+        int pipe_fds[2];
+        if (pipe(pipe_fds) != 0) {
+            state.SkipWithError("pipe() failed");
+            return;
+        }
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, pipe_fds[1], STDOUT_FILENO);
+        posix_spawn_file_actions_addclose(&actions, pipe_fds[0]);
+
+        pid_t pid;
+        int spawned = posix_spawn(&pid, ITMOSCRIPT_CLI, &actions, nullptr, argv, environ);
+        posix_spawn_file_actions_destroy(&actions);
+        close(pipe_fds[1]);
+        if (spawned != 0) {
+            close(pipe_fds[0]);
+            state.SkipWithError("Cannot start " ITMOSCRIPT_CLI);
+            return;
+        }
+
+        char first;
+        bool got_output = read(pipe_fds[0], &first, 1) == 1;
+        state.PauseTiming();
+        close(pipe_fds[0]);
+        waitpid(pid, nullptr, 0);
+        state.ResumeTiming();
+        if (!got_output) {
+            state.SkipWithError("No output from " ITMOSCRIPT_CLI);
+            return;
+        }
+    }
+}
+
+BENCHMARK_CAPTURE(BM_Lex, function_calls, std::string("function_calls"));
+BENCHMARK_CAPTURE(BM_Lex, list_builtins, std::string("list_builtins"));
+BENCHMARK_CAPTURE(BM_Parse, function_calls, std::string("function_calls"));
+BENCHMARK_CAPTURE(BM_Parse, list_builtins, std::string("list_builtins"));
+
+BENCHMARK_CAPTURE(BM_Run, arithmetic, std::string("arithmetic"))->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Run, function_calls, std::string("function_calls"))->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Run, list_builtins, std::string("list_builtins"))->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Run, string_builtins, std::string("string_builtins"))->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Run, printing, std::string("printing"))->Unit(benchmark::kMillisecond);
+
+BENCHMARK_CAPTURE(BM_RunWithBudget, arithmetic, std::string("arithmetic"))->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_RunWithBudget, function_calls, std::string("function_calls"))->Unit(benchmark::kMillisecond);
+
+BENCHMARK_CAPTURE(BM_LargeFile, file_lines, std::string("file_lines"))->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_LargeFile, file_chunks, std::string("file_chunks"))->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_LargeFile, file_bytes, std::string("file_bytes"))->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_FirstOutput)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ColdStart)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+BENCHMARK(BM_PmapThreads)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
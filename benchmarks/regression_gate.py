@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""Runs itmoscript_bench several times and compares it with a stored baseline.
+
+For every benchmark the script takes the median wall time over the runs and
+a bootstrap confidence interval for that median. A benchmark regresses when
+its median is more than --threshold percent above the baseline median and
+the two confidence intervals do not overlap, so noise alone does not fail
+the gate. The exit code is 1 if anything regressed.
+
+    regression_gate.py --bench build/benchmarks/itmoscript_bench \\
+                       --baseline benchmarks/baseline.json
+
+--update-baseline writes the current results to the baseline file instead
+of comparing. Baselines are only comparable on the machine that made them.
+"""
+
+import argparse
+import json
+import os
+import random
+import statistics
+import subprocess
+import sys
+import tempfile
+
+TIME_UNITS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def run_benchmarks(bench, repetitions, min_time, benchmark_filter):
+    with tempfile.TemporaryDirectory() as tmp:
+        out = os.path.join(tmp, "results.json")
+        command = [
+            bench,
+            "--benchmark_repetitions=%d" % repetitions,
+            # Spreads the repetitions of each benchmark over the whole run,
+            # so a slow spell on the machine does not hit one benchmark only.
+            "--benchmark_enable_random_interleaving=true",
+            "--benchmark_min_time=%g" % min_time,
+            "--benchmark_out=" + out,
+            "--benchmark_out_format=json",
+        ]
+        if benchmark_filter:
+            command.append("--benchmark_filter=" + benchmark_filter)
+        subprocess.run(command, check=True, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        with open(out) as f:
+            report = json.load(f)
+
+    samples = {}
+    for entry in report["benchmarks"]:
+        if entry.get("run_type", "iteration") != "iteration" or entry.get("error_occurred"):
+            continue
+        name = entry.get("run_name", entry["name"])
+        scale = TIME_UNITS[entry.get("time_unit", "ns")]
+        samples.setdefault(name, []).append(entry["real_time"] * scale)
+    return samples
+
+
+def median_interval(values, confidence, resamples=2000):
+    """Median of `values` and a bootstrap confidence interval for it."""
+    rng = random.Random(0)
+    medians = sorted(
+        statistics.median(rng.choice(values) for _ in values) for _ in range(resamples)
+    )
+    tail = (1 - confidence) / 2
+    low = medians[int(tail * (resamples - 1))]
+    high = medians[int((1 - tail) * (resamples - 1))]
+    return statistics.median(values), low, high
+
+
+def summarize(samples, confidence):
+    summary = {}
+    for name, values in samples.items():
+        median, low, high = median_interval(values, confidence)
+        summary[name] = {"median_ns": median, "ci_low_ns": low, "ci_high_ns": high, "runs": len(values)}
+    return summary
+
+
+def format_time(ns):
+    for unit, scale in (("s", 1e9), ("ms", 1e6), ("us", 1e3)):
+        if ns >= scale:
+            return "%.3f %s" % (ns / scale, unit)
+    return "%.0f ns" % ns
+
+
+def compare(baseline, current, threshold):
+    rows = []
+    regressions = []
+    for name in sorted(set(baseline) | set(current)):
+        if name not in current:
+            rows.append((name, format_time(baseline[name]["median_ns"]), "-", "-", "missing"))
+            continue
+        if name not in baseline:
+            rows.append((name, "-", format_time(current[name]["median_ns"]), "-", "new"))
+            continue
+        old, new = baseline[name], current[name]
+        change = (new["median_ns"] / old["median_ns"] - 1) * 100
+        status = "ok"
+        if change > threshold and new["ci_low_ns"] > old["ci_high_ns"]:
+            status = "REGRESSION"
+            regressions.append(name)
+        elif change < -threshold and new["ci_high_ns"] < old["ci_low_ns"]:
+            status = "faster"
+        rows.append((name, format_time(old["median_ns"]), format_time(new["median_ns"]), "%+.1f%%" % change, status))
+
+    header = ("benchmark", "baseline", "current", "change", "status")
+    widths = [max(len(row[i]) for row in rows + [header]) for i in range(len(header))]
+    for row in [header] + rows:
+        print("  ".join(cell.ljust(width) for cell, width in zip(row, widths)).rstrip())
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--bench", required=True, help="path to itmoscript_bench")
+    parser.add_argument("--baseline", required=True, help="baseline JSON file")
+    parser.add_argument("--repetitions", type=int, default=7, help="runs of every benchmark (default 7)")
+    parser.add_argument("--min-time", type=float, default=0.1, help="seconds per benchmark run (default 0.1)")
+    parser.add_argument("--threshold", type=float, default=15.0, help="allowed slowdown in percent (default 15)")
+    parser.add_argument("--confidence", type=float, default=0.95, help="confidence level (default 0.95)")
+    parser.add_argument("--filter", default="", help="regex passed as --benchmark_filter")
+    parser.add_argument("--update-baseline", action="store_true", help="store the results as the new baseline")
+    args = parser.parse_args()
+
+    current = summarize(run_benchmarks(args.bench, args.repetitions, args.min_time, args.filter), args.confidence)
+
+    if args.update_baseline:
+        with open(args.baseline, "w") as f:
+            json.dump({"benchmarks": current}, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print("Baseline with %d benchmarks written to %s" % (len(current), args.baseline))
+        return 0
+
+    with open(args.baseline) as f:
+        baseline = json.load(f)["benchmarks"]
+
+    regressions = compare(baseline, current, args.threshold)
+    if regressions:
+        print("\n%d benchmark(s) slower than the baseline by more than %g%%: %s"
+              % (len(regressions), args.threshold, ", ".join(regressions)))
+        return 1
+    print("\nNo regressions beyond %g%%." % args.threshold)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,202 @@
+#include "lib/interpreter/interpreter.h"
+#include "lib/interpreter/coverage.h"
+#include "lib/interpreter/heap_profiler.h"
+#include "lib/interpreter/profiler.h"
+#include "lib/interpreter/run_stats.h"
+#include "lib/interpreter/tracer.h"
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace {
+
+const char* kUsage = R"(usage: itmoscript [options] [script]
+
+Runs the script, or standard input when it is omitted or "-".
+
+options:
+  --timeout MS          stop the run after MS milliseconds
+  --max-steps N         stop the run after N loop iterations and calls
+  --max-alloc BYTES     cap the bytes of strings and lists allocated over the run
+  --threads N           threads used by map, filter and pmap
+  --memo-cache N        cache size of memoize(fn) without an explicit one
+  --profile             print per-function and per-line time tables to stderr
+  --profile-out FILE    write sampled stacks in collapsed format to FILE
+  --stats               print lookup, allocation and call counters to stderr
+  --heap                print live script values by kind and line to stderr
+  --coverage FILE       write line coverage to FILE (JSON if it ends in .json,
+                        lcov otherwise)
+  --trace FILE          write a Chrome trace_event timeline to FILE
+  -h, --help            show this help
+)";
+
+struct Options {
+    std::string script = "-";
+    Budget budget;
+    std::optional<unsigned> threads;
+    std::optional<size_t> memo_cache;
+    bool profile = false;
+    std::string profile_out;
+    bool stats = false;
+    bool heap = false;
+    std::string coverage_out;
+    std::string trace_out;
+};
+
+template <typename T>
+T parse_number(std::string_view flag, std::string_view text) {
+    T value{};
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc() || end != text.data() + text.size()) {
+        throw std::runtime_error(std::string(flag) + " expects a number, got '" + std::string(text) + "'");
+    }
+    return value;
+}
+
+Options parse_options(int argc, char** argv) {
+    Options options;
+    bool have_script = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        auto value = [&]() -> std::string_view {
+            if (i + 1 >= argc) throw std::runtime_error(std::string(arg) + " expects a value");
+            return argv[++i];
+        };
+
+        if (arg == "--timeout") {
+            options.budget.timeout = std::chrono::milliseconds(parse_number<int64_t>(arg, value()));
+        } else if (arg == "--max-steps") {
+            options.budget.max_steps = parse_number<uint64_t>(arg, value());
+        } else if (arg == "--max-alloc") {
+            options.budget.max_alloc_bytes = parse_number<size_t>(arg, value());
+        } else if (arg == "--threads") {
+            options.threads = parse_number<unsigned>(arg, value());
+        } else if (arg == "--memo-cache") {
+            options.memo_cache = parse_number<size_t>(arg, value());
+        } else if (arg == "--profile") {
+            options.profile = true;
+        } else if (arg == "--profile-out") {
+            options.profile_out = value();
+        } else if (arg == "--stats") {
+            options.stats = true;
+        } else if (arg == "--heap") {
+            options.heap = true;
+        } else if (arg == "--coverage") {
+            options.coverage_out = value();
+        } else if (arg == "--trace") {
+            options.trace_out = value();
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            throw std::runtime_error("unknown option " + std::string(arg));
+        } else if (have_script) {
+            throw std::runtime_error("only one script can be run");
+        } else {
+            options.script = arg;
+            have_script = true;
+        }
+    }
+    return options;
+}
+
+std::ofstream open_output(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("cannot write " + path);
+    return out;
+}
+
+bool ends_with(const std::string& text, std::string_view suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+}
+
+int main(int argc, char** argv) {
+    // The interpreter only writes through std::cout; keeping it in step with
+    // C stdio would make every write go through stdio's locking.
+    std::ios::sync_with_stdio(false);
+
+    Options options;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg = argv[i];
+            if (arg == "-h" || arg == "--help") {
+                std::cout << kUsage;
+                return 0;
+            }
+        }
+        options = parse_options(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "itmoscript: " << e.what() << '\n' << kUsage;
+        return 2;
+    }
+
+    std::shared_ptr<const Program> program;
+    if (options.script == "-") {
+        program = Program::compile(std::cin);
+    } else {
+        std::ifstream source(options.script);
+        if (!source) {
+            std::cerr << "itmoscript: cannot open " << options.script << '\n';
+            return 2;
+        }
+        program = Program::compile(source);
+    }
+
+    Interpreter interpreter(std::cout, std::cin);
+    interpreter.set_budget(options.budget);
+    if (options.threads) interpreter.set_threads(*options.threads);
+    if (options.memo_cache) interpreter.set_memo_capacity(*options.memo_cache);
+
+    std::unique_ptr<Profiler> profiler;
+    if (options.profile || !options.profile_out.empty()) {
+        profiler = std::make_unique<Profiler>();
+        interpreter.set_profiler(profiler.get());
+    }
+    RunStats stats;
+    if (options.stats) interpreter.set_stats(&stats);
+    HeapProfiler heap;
+    if (options.heap) interpreter.set_heap_profiler(&heap);
+    Coverage coverage;
+    if (!options.coverage_out.empty()) interpreter.set_coverage(&coverage);
+    std::unique_ptr<Tracer> tracer;
+    if (!options.trace_out.empty()) {
+        tracer = std::make_unique<Tracer>();
+        interpreter.set_tracer(tracer.get());
+    }
+
+    bool ok = interpreter.run(*program);
+    std::cout.flush();
+
+    try {
+        if (options.profile) {
+            profiler->write_table(std::cerr);
+            std::cerr << '\n';
+            profiler->write_lines(std::cerr);
+        }
+        if (!options.profile_out.empty()) {
+            std::ofstream out = open_output(options.profile_out);
+            profiler->write_collapsed(out);
+        }
+        if (options.stats) stats.write(std::cerr);
+        if (options.heap) heap.write_report(std::cerr);
+        if (!options.coverage_out.empty()) {
+            std::ofstream out = open_output(options.coverage_out);
+            if (ends_with(options.coverage_out, ".json")) coverage.write_json(out, options.script);
+            else coverage.write_lcov(out, options.script);
+        }
+        if (tracer) {
+            std::ofstream out = open_output(options.trace_out);
+            tracer->write_json(out);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "itmoscript: " << e.what() << '\n';
+        return 2;
+    }
+
+    return ok ? 0 : 1;
+}
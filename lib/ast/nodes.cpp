@@ -1,9 +1,23 @@
 #include "nodes.h"
 #include "tokens/tokens.h"
+#include "interpreter/call_stack.h"
+#include "interpreter/context.h"
+#include "interpreter/memo_table.h"
+#include "interpreter/stack_segments.h"
+#include "interpreter/thread_pool.h"
+#include "io/input_reader.h"
+#include "io/mapped_file.h"
+#include "text/text.h"
 #include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <climits>
 #include <cmath>
 #include <cstddef>
-#include <iostream>
+#include <cstring>
+#include <exception>
+#include <istream>
+#include <ostream>
 #include <memory>
 #include <random>
 #include <ranges>
@@ -33,76 +47,118 @@ std::ostream& operator<<(std::ostream& os, const Value& v) {
     return os;
 }
 
-std::shared_ptr<ListValue> operator+(const std::shared_ptr<ListValue>& first, const std::shared_ptr<ListValue>& second) {
-    for (auto& v : second->items) first->items.push_back(v);
+// Strings and lists built by the script count against the run's heap budget.
+template <typename... Args>
+static std::shared_ptr<std::string> make_string(Args&&... args) {
+    ExecutionContext& context = current_context();
+    auto str = context.heap
+        ? context.heap->track(new std::string(std::forward<Args>(args)...), HeapKind::String, context.line)
+        : std::make_shared<std::string>(std::forward<Args>(args)...);
+    context.charge(str->size());
+    context.count(RunStats::StringAllocations);
+    return str;
+}
 
-    return first;
+// Items are charged by the caller as they are added.
+static std::shared_ptr<ListValue> make_list() {
+    ExecutionContext& context = current_context();
+    context.count(RunStats::ListAllocations);
+    if (context.heap) return context.heap->track(new ListValue, HeapKind::List, context.line);
+    return std::make_shared<ListValue>();
 }
 
-template <typename T>
-std::shared_ptr<ListValue> operator*(const std::shared_ptr<ListValue>& list, T count) {
-    auto x = static_cast<int>(count);
+static void charge_items(size_t count) {
+    current_context().charge(count * sizeof(Value));
+}
+
+// Runs statements in order until one of them hands control back to the
+// enclosing call (return or a tail call). Returns false in that case.
+template <typename Statements>
+static bool run_block(const Statements& body, SymbolTable& symbols, std::ostream& out, ExecutionContext& context) {
+    uint32_t enclosing = context.line;
+    for (auto& stmt : body) {
+        context.line = stmt->line;
+        context.hit_line(stmt->line);
+        try {
+            stmt->get(symbols, out);
+        } catch (const LocatedError&) {
+            throw;
+        } catch (const std::exception& e) {
+            throw LocatedError(e.what(), stmt->line);
+        }
+        if (context.control != Control::None) {
+            context.line = enclosing;
+            return false;
+        }
+    }
+    context.line = enclosing;
+    return true;
+}
+
+// Like strings, lists are never changed by + and *: the result is a new list,
+// so values other code can see (a pmap worker's, say) stay as they were.
+std::shared_ptr<ListValue> operator+(const std::shared_ptr<ListValue>& first, const std::shared_ptr<ListValue>& second) {
+    charge_items(first->items.size() + second->items.size());
+    auto result = make_list();
+    result->items.reserve(first->items.size() + second->items.size());
+    result->items.insert(result->items.end(), first->items.begin(), first->items.end());
+    result->items.insert(result->items.end(), second->items.begin(), second->items.end());
+    return result;
+}
+
+static std::shared_ptr<ListValue> repeat(const ListValue& list, int x) {
     if (x < 0) throw std::runtime_error("The multiplier must be >= 0 ");
-    if (x == 0) { *list = {}; return list; }
 
-    ListValue copy;
-    for (auto& v : list->items) copy.items.push_back(v);
+    charge_items(list.items.size() * x);
+    auto result = make_list();
+    result->items.reserve(list.items.size() * x);
+    while (x--) result->items.insert(result->items.end(), list.items.begin(), list.items.end());
 
-    for (auto i : std::views::iota(0, x - 1)) {
-        for (auto& v : copy.items)  list->items.push_back(v);
-    }
-    
-    return list;
+    return result;
+}
+
+template <typename T>
+std::shared_ptr<ListValue> operator*(const std::shared_ptr<ListValue>& list, T count) {
+    return repeat(*list, static_cast<int>(count));
 }
 
 template <typename T>
 std::shared_ptr<ListValue> operator*(T count, const std::shared_ptr<ListValue>& list) {
-    auto x = static_cast<int>(count);
-    if (x < 0) throw std::runtime_error("The multiplier must be >= 0 ");
-    if (x == 0) { *list = {}; return list; }
+    return repeat(*list, static_cast<int>(count));
+}
 
-    ListValue copy;
-    for (auto& v : list->items) copy.items.push_back(v);
 
-    for (auto i : std::views::iota(0, x - 1)) {
-        for (auto& v : copy.items)  list->items.push_back(v);
-    }
-    
-    return list;
-}
+static std::shared_ptr<std::string> repeat(const std::string& str, int x) {
+    if (x < 0) throw std::runtime_error("The multiplier must be >= 0");
 
+    current_context().charge(str.size() * x);
+    auto result = make_string();
+    result->reserve(str.size() * x);
+    while (x--) result->append(str);
 
-std::shared_ptr<std::string> operator*(int n, const std::shared_ptr<std::string>& str) {
-    std::string copy = *str;
-    auto x = static_cast<int>(n);
-    if (x < 0) throw std::runtime_error("The multiplier must be >= 0 ");
-    if (x == 0) { *str = ""; return str; }
-    --x;
-    while (x--) *str += copy;
+    return result;
+}
 
-    return str;
+std::shared_ptr<std::string> operator*(int n, const std::shared_ptr<std::string>& str) {
+    return repeat(*str, n);
 }
 
 template<typename T>
 std::shared_ptr<std::string> operator*(const std::shared_ptr<std::string>& str, T n) {
-    std::string copy = *str;
-    auto x = static_cast<int>(n);
-    if (x < 0) throw std::runtime_error("The multiplier must be >= 0");
-    if (x == 0) { *str = ""; return str; }
-    --x;
-    while (x--) *str += copy;
-
-    return str;
+    return repeat(*str, static_cast<int>(n));
 }
 
 std::shared_ptr<std::string> operator+(const std::shared_ptr<std::string>& first, const std::shared_ptr<std::string>& second) {
-    *first += *second;
-    return first;
+    current_context().charge(first->size() + second->size());
+    auto result = make_string();
+    result->reserve(first->size() + second->size());
+    result->append(*first).append(*second);
+    return result;
 }
 
 std::shared_ptr<std::string> operator-(const std::shared_ptr<std::string>& first, const std::shared_ptr<std::string>& second) {
     if (first->size() >= second->size() && first->compare(first->size() - second->size(), second->size(), *second) == 0) {
-        *first = first->substr(0, first->size() - second->size());
+        return make_string(*first, 0, first->size() - second->size());
     }
         
     return first;
@@ -114,7 +170,10 @@ Value NumberNode::get(SymbolTable&, std::ostream& out)  { return value; }
 
 
 VariableNode::VariableNode(const std::string& n) : name(n) {}
-Value VariableNode::get(SymbolTable& symbols, std::ostream& out) { return symbols.get_variable(name); }
+Value VariableNode::get(SymbolTable& symbols, std::ostream& out) {
+    current_context().count(RunStats::Lookups);
+    return symbols.get_variable(name);
+}
 std::string& VariableNode::get_name() { return name; }
 
 
@@ -383,7 +442,7 @@ Value BinOpNode::get(SymbolTable& symbols, std::ostream& out) {
             return std::get<bool>(lval) == std::get<bool>(rval);
         }
         if (std::holds_alternative<std::shared_ptr<std::string>>(lval) && std::holds_alternative<std::shared_ptr<std::string>>(rval)) {
-            return std::get<std::shared_ptr<std::string>>(lval) == std::get<std::shared_ptr<std::string>>(rval);
+            return *std::get<std::shared_ptr<std::string>>(lval) == *std::get<std::shared_ptr<std::string>>(rval);
         }
         if (std::holds_alternative<FunctionValue>(lval) && std::holds_alternative<FunctionValue>(rval)) {
             throw std::runtime_error("Cannot compare functions with == ");
@@ -416,11 +475,14 @@ Value BinOpNode::get(SymbolTable& symbols, std::ostream& out) {
             return std::get<bool>(lval) != std::get<bool>(rval);
         }
         if (std::holds_alternative<std::shared_ptr<std::string>>(lval) && std::holds_alternative<std::shared_ptr<std::string>>(rval)) {
-            return std::get<std::shared_ptr<std::string>>(lval) != std::get<std::shared_ptr<std::string>>(rval);
+            return *std::get<std::shared_ptr<std::string>>(lval) != *std::get<std::shared_ptr<std::string>>(rval);
         }
         if (std::holds_alternative<FunctionValue>(lval) && std::holds_alternative<FunctionValue>(rval)) {
             throw std::runtime_error("Cannot compare functions with == ");
         }
+        if (std::holds_alternative<Nil>(lval) || std::holds_alternative<Nil>(rval)) {
+            return !(std::holds_alternative<Nil>(lval) && std::holds_alternative<Nil>(rval));
+        }
         throw std::runtime_error("Type mismatch in '==' operation");
     }
     if (op == TokenType::LESS) {
@@ -467,6 +529,7 @@ Value BinOpNode::get(SymbolTable& symbols, std::ostream& out) {
 PrintNode::PrintNode(std::unique_ptr<ASTNode> e) : expr(std::move(e)) {}
 Value PrintNode::get(SymbolTable& symbols, std::ostream& out) {
     Value val = expr->get(symbols, out);
+    TraceScope trace(current_context(), "print", "io");
     out << val;
     
     return val;
@@ -475,17 +538,92 @@ Value PrintNode::get(SymbolTable& symbols, std::ostream& out) {
 PrintlnNode::PrintlnNode(std::unique_ptr<ASTNode> e) : expr(std::move(e)) {}
 Value PrintlnNode::get(SymbolTable& symbols, std::ostream& out) {
     Value val = expr->get(symbols, out);
+    TraceScope trace(current_context(), "println", "io");
     out << val << std::endl;
     
     return val;
 }
 
-ReadNode::ReadNode() {
-    std::getline(std::cin, expr);
-}
+ReadNode::ReadNode() {}
 Value ReadNode::get(SymbolTable& symbols, std::ostream& out) {
-    auto string = std::make_shared<std::string>(expr);
-    return string;
+    TraceScope trace(current_context(), "read", "io");
+    std::string_view line;
+    if (!current_context().reader().next_line(line)) return Nil{};
+    return make_string(line);
+}
+
+Value LinesNode::get(SymbolTable& symbols, std::ostream& out) {
+    auto list = make_list();
+    for_each_line(symbols, out, [&](std::string_view line) {
+        charge_items(1);
+        list->items.push_back(make_string(line));
+        return true;
+    });
+    return list;
+}
+
+static const std::string& to_path(const Value& v, const char* fn) {
+    if (!std::holds_alternative<std::shared_ptr<std::string>>(v)) {
+        throw std::runtime_error(std::string(fn) + "() argument must be a string");
+    }
+    return *std::get<std::shared_ptr<std::string>>(v);
+}
+
+void LinesNode::for_each_line(SymbolTable& symbols, std::ostream& out, const std::function<bool(std::string_view)>& fn) {
+    std::unique_ptr<InputReader> file;
+    if (path) {
+        Value p = path->get(symbols, out);
+        file = std::make_unique<InputReader>(to_path(p, "file_lines"));
+    }
+
+    InputReader& reader = file ? *file : current_context().reader();
+    std::string_view line;
+    while (reader.next_line(line)) {
+        if (!fn(line)) break;
+    }
+}
+
+// Byte offsets and counts may go past what an int holds, so whole doubles
+// are accepted too.
+static size_t to_file_size(const Value& v, const char* fn, const char* what) {
+    double size;
+    if (std::holds_alternative<int>(v)) size = std::get<int>(v);
+    else if (std::holds_alternative<double>(v)) size = std::get<double>(v);
+    else throw std::runtime_error(std::string(fn) + "() " + what + " must be a number");
+    if (!(size >= 0)) throw std::runtime_error(std::string(fn) + "() " + what + " must not be negative");
+    return static_cast<size_t>(std::min(size, 0x1p62));
+}
+
+// The part of a mapped file selected by the optional offset and count
+// arguments; ranges past the end are cut to the file.
+static std::string_view file_window(std::string_view contents, ASTNode* offset, ASTNode* count,
+                                    SymbolTable& symbols, std::ostream& out, const char* fn) {
+    if (!offset) return contents;
+    size_t from = std::min(to_file_size(offset->get(symbols, out), fn, "offset"), contents.size());
+    size_t length = count ? to_file_size(count->get(symbols, out), fn, "count") : std::string_view::npos;
+    return contents.substr(from, length);
+}
+
+Value ReadFileNode::get(SymbolTable& symbols, std::ostream& out) {
+    Value p = path->get(symbols, out);
+    TraceScope trace(current_context(), "read_file", "io");
+    MappedFile file(to_path(p, "read_file"));
+    return make_string(file_window(file.view(), offset.get(), count.get(), symbols, out, "read_file"));
+}
+
+Value FileBytesNode::get(SymbolTable& symbols, std::ostream& out) {
+    Value p = path->get(symbols, out);
+    TraceScope trace(current_context(), "file_bytes", "io");
+    MappedFile file(to_path(p, "file_bytes"));
+    std::string_view bytes = file_window(file.view(), offset.get(), count.get(), symbols, out, "file_bytes");
+
+    charge_items(bytes.size());
+    auto list = make_list();
+    list->items.reserve(bytes.size());
+    for (unsigned char c : bytes) {
+        list->items.push_back(static_cast<int>(c));
+    }
+    return list;
 }
 
 IfNode::IfNode(std::unique_ptr<ASTNode> cond, 
@@ -499,37 +637,32 @@ IfNode::IfNode(std::unique_ptr<ASTNode> cond,
 {}
 
 Value IfNode::get(SymbolTable& symbols, std::ostream& out) {
+    ExecutionContext& context = current_context();
     Value cond_val = condition->get(symbols, out);
     
     if (is_truthy(cond_val)) {
-        for (auto& expr : then_branch) {
-            expr->get(symbols, out);
-        }
+        run_block(then_branch, symbols, out, context);
         return {};
     }
     
     for (auto& elif : else_if_branches) {
         Value elif_val = elif.condition->get(symbols, out);
         if (is_truthy(elif_val)) {
-            for (auto& expr : elif.body) {
-                expr->get(symbols, out);
-            }
+            run_block(elif.body, symbols, out, context);
             return {};
         }
     }
     
     if (!else_branch.empty()) {
-        for (auto& expr : else_branch) {
-            expr->get(symbols, out);
-        }
+        run_block(else_branch, symbols, out, context);
     }
     
     return {};
 }
 
-StringNode::StringNode(const std::string& val) : value(val) {}
+StringNode::StringNode(std::shared_ptr<std::string> val) : value(std::move(val)) {}
 Value StringNode::get(SymbolTable&, std::ostream&) {
-    return std::make_shared<std::string>(value);
+    return value;
 }
 
 BoolNode::BoolNode(const std::string& val) {
@@ -545,6 +678,24 @@ Value NilNode::get(SymbolTable&, std::ostream&) {
 }
 
 Value ForNode::get(SymbolTable& symbols, std::ostream& out) {
+    ExecutionContext& context = current_context();
+
+    if (lines_expr != nullptr) {
+        lines_expr->for_each_line(symbols, out, [&](std::string_view line) {
+            context.step();
+            symbols.add_variable(var_name, make_string(line));
+            try {
+                if (!run_block(body, symbols, out, context)) return false;
+            } catch (const ContinueException&) {
+                return true;
+            } catch (const BreakException&) {
+                return false;
+            }
+            return true;
+        });
+        return Nil{};
+    }
+
     if (iterable_expr == nullptr) {
         Value s_val = start_expr->get(symbols, out);
         Value e_val = end_expr->get(symbols, out);
@@ -580,11 +731,10 @@ Value ForNode::get(SymbolTable& symbols, std::ostream& out) {
 
         if (st > 0) {
             for (int i = s; i < e; i += st) {
+                context.step();
                 symbols.add_variable(var_name, i);
                 try {
-                    for (auto& stmt : body) {
-                        stmt->get(symbols, out);
-                    }
+                    if (!run_block(body, symbols, out, context)) return Nil{};
                 } catch (const ContinueException&) {
                     continue;
                 } catch (const BreakException&) {
@@ -593,11 +743,10 @@ Value ForNode::get(SymbolTable& symbols, std::ostream& out) {
             }
         } else {
             for (int i = s; i > e; i += st) {
+                context.step();
                 symbols.add_variable(var_name, i);
                 try {
-                    for (auto& stmt : body) {
-                        stmt->get(symbols, out);
-                    }
+                    if (!run_block(body, symbols, out, context)) return Nil{};
                 } catch (const ContinueException&) {
                     continue;
                 } catch (const BreakException&) {
@@ -610,11 +759,10 @@ Value ForNode::get(SymbolTable& symbols, std::ostream& out) {
         Value iter = iterable_expr->get(symbols, out);
         if (auto p = std::get_if<std::shared_ptr<ListValue>>(&iter)) {
             for (auto& v : (*p)->items) {
+                context.step();
                 symbols.add_variable(var_name, v);
                 try {
-                    for (auto& stmt : body) {
-                        stmt->get(symbols, out);
-                    }
+                    if (!run_block(body, symbols, out, context)) return Nil{};
                 } catch (const ContinueException&) {
                     continue;
                 } catch (const BreakException&) {
@@ -628,11 +776,10 @@ Value ForNode::get(SymbolTable& symbols, std::ostream& out) {
             const auto& s = std::get<std::shared_ptr<std::string>>(iter);
             for (char c : *s) {
                 SymbolTable child = symbols.create_child();
-                child.add_variable(var_name, std::make_shared<std::string>(1, c));
+                context.step();
+                child.add_variable(var_name, make_string(1, c));
                 try {
-                    for (auto& stmt : body) {
-                        stmt->get(symbols, out);
-                    }
+                    if (!run_block(body, symbols, out, context)) return Nil{};
                 } catch (const ContinueException&) {
                     continue;
                 } catch (const BreakException&) {
@@ -747,10 +894,8 @@ Value SqrtNode::get(SymbolTable& symbols, std::ostream& out) {
 }
 
 int random(int min, int max) {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
     std::uniform_int_distribution<> dist(min, max);
-    return dist(gen);
+    return dist(current_context().rng());
 }
 
 Value RndNode::get(SymbolTable& symbols, std::ostream& out) {
@@ -784,7 +929,7 @@ Value ToStringNode::get(SymbolTable& symbols, std::ostream& out) {
         auto& lst = std::get<int>(v);
         try {
             std::string n = std::to_string(lst);
-            return std::make_shared<std::string>(n);
+            return make_string(n);
         } catch (...) {
             return Nil{};
         }
@@ -793,65 +938,83 @@ Value ToStringNode::get(SymbolTable& symbols, std::ostream& out) {
     throw std::runtime_error("to_string() argument must be a int");
 }
 
-std::string toLower(std::string str) {
-    std::transform(str.begin(), str.end(), str.begin(),
-        [](unsigned char c) { return std::tolower(c); });
-    return str;
-}
-
 Value LowerNode::get(SymbolTable& symbols, std::ostream& out) {
     Value v = expr->get(symbols, out);
     if (std::holds_alternative<std::shared_ptr<std::string>>(v)) {
         auto& lst = std::get<std::shared_ptr<std::string>>(v);
-        return std::make_shared<std::string>(toLower(*lst));
+        return make_string(lower_case(*lst));
     }
 
     throw std::runtime_error("lower() argument must be a string");
 }
 
-std::string toUpper(std::string str) {
-    std::transform(str.begin(), str.end(), str.begin(),
-        [](unsigned char c) { return std::toupper(c); });
-    return str;
-}
-
 Value UpperNode::get(SymbolTable& symbols, std::ostream& out) {
     Value v = expr->get(symbols, out);
     if (std::holds_alternative<std::shared_ptr<std::string>>(v)) {
         auto& lst = std::get<std::shared_ptr<std::string>>(v);
-        return std::make_shared<std::string>(toUpper(*lst));
+        return make_string(upper_case(*lst));
     }
 
     throw std::runtime_error("upper() argument must be a string");
 }
 
-std::vector<std::string> split(const std::string& str, const std::string& delimiter) {
-    std::vector<std::string> tokens;
-    size_t start = 0;
-    size_t end = str.find(delimiter);
-    
-    while (end != std::string::npos) {
-        tokens.push_back(str.substr(start, end - start));
-        start = end + delimiter.length();
-        end = str.find(delimiter, start);
+Value IsDigitNode::get(SymbolTable& symbols, std::ostream& out) {
+    Value v = expr->get(symbols, out);
+    if (std::holds_alternative<std::shared_ptr<std::string>>(v)) {
+        return all_digits(*std::get<std::shared_ptr<std::string>>(v));
     }
-    tokens.push_back(str.substr(start));
-    
-    return tokens;
+
+    throw std::runtime_error("is_digit() argument must be a string");
+}
+
+Value IsAlphaNode::get(SymbolTable& symbols, std::ostream& out) {
+    Value v = expr->get(symbols, out);
+    if (std::holds_alternative<std::shared_ptr<std::string>>(v)) {
+        return all_alpha(*std::get<std::shared_ptr<std::string>>(v));
+    }
+
+    throw std::runtime_error("is_alpha() argument must be a string");
+}
+
+Value TrimNode::get(SymbolTable& symbols, std::ostream& out) {
+    Value v = expr->get(symbols, out);
+    if (std::holds_alternative<std::shared_ptr<std::string>>(v)) {
+        auto& s = std::get<std::shared_ptr<std::string>>(v);
+        std::string_view trimmed = trim_view(*s);
+        if (trimmed.size() == s->size()) return s;
+        return make_string(trimmed);
+    }
+
+    throw std::runtime_error("trim() argument must be a string");
+}
+
+Value CountNode::get(SymbolTable& symbols, std::ostream& out) {
+    Value e = expr->get(symbols, out);
+    Value n = needle->get(symbols, out);
+
+    if (std::holds_alternative<std::shared_ptr<std::string>>(e) && std::holds_alternative<std::shared_ptr<std::string>>(n)) {
+        return static_cast<int>(count_substring(*std::get<std::shared_ptr<std::string>>(e),
+                                                *std::get<std::shared_ptr<std::string>>(n)));
+    }
+
+    throw std::runtime_error("count() arguments must be a string");
 }
 
 Value SplitNode::get(SymbolTable& symbols, std::ostream& out) {
     Value e = expr->get(symbols, out);
     Value d = delim->get(symbols, out);
+    TraceScope trace(current_context(), "split", "builtin");
 
     if (std::holds_alternative<std::shared_ptr<std::string>>(e) && std::holds_alternative<std::shared_ptr<std::string>>(d)) {
         auto& s = std::get<std::shared_ptr<std::string>>(e);
         auto& del = std::get<std::shared_ptr<std::string>>(d);
-        std::vector<std::string> parts = split(*s, *del);
+        std::vector<std::string_view> parts = split_views(*s, *del);
 
-        auto list = std::make_shared<ListValue>();
+        charge_items(parts.size());
+        auto list = make_list();
+        list->items.reserve(parts.size());
         for (const auto& part : parts) {
-            list->items.push_back(std::make_shared<std::string>(part));
+            list->items.push_back(make_string(part));
         }
 
         return list;
@@ -860,52 +1023,55 @@ Value SplitNode::get(SymbolTable& symbols, std::ostream& out) {
     throw std::runtime_error("split() arguments must be a string");
 }
 
+static char* format_scalar(const Value& v, char* first, char* last) {
+    if (std::holds_alternative<int>(v)) {
+        return std::to_chars(first, last, std::get<int>(v)).ptr;
+    }
+    if (std::holds_alternative<double>(v)) {
+        return std::to_chars(first, last, std::get<double>(v), std::chars_format::fixed, 6).ptr;
+    }
+    if (std::holds_alternative<bool>(v)) {
+        *first = std::get<bool>(v) ? '1' : '0';
+        return first + 1;
+    }
+    return first;
+}
+
 Value JoinNode::get(SymbolTable& symbols, std::ostream& out) {
     Value e = expr->get(symbols, out);
     Value d = delim->get(symbols, out);
+    TraceScope trace(current_context(), "join", "builtin");
     
     if (std::holds_alternative<std::shared_ptr<ListValue>>(e) && std::holds_alternative<std::shared_ptr<std::string>>(d)) {
-        auto& v = std::get<std::shared_ptr<ListValue>>(e);
-        auto& del = std::get<std::shared_ptr<std::string>>(d);
-
-        std::string string = "";
-        int count = 0;
-
-        for (auto& i : v->items) {
-            ++count;
-            if (std::holds_alternative<std::shared_ptr<std::string>>(i)) string += *std::get<std::shared_ptr<std::string>>(i);
-
-            else if (std::holds_alternative<int>(i)){
-                try {
-                    string += std::to_string(std::get<int>(i));
-                } catch(...) {
-                    string += *del;
-                    continue;
+        const auto& items = std::get<std::shared_ptr<ListValue>>(e)->items;
+        const std::string& del = *std::get<std::shared_ptr<std::string>>(d);
+
+        char scratch[512];
+        size_t total = items.empty() ? 0 : del.size() * (items.size() - 1);
+        for (auto& i : items) {
+            if (auto s = std::get_if<std::shared_ptr<std::string>>(&i)) total += (*s)->size();
+            else total += format_scalar(i, scratch, scratch + sizeof(scratch)) - scratch;
+        }
+
+        std::string result;
+        result.resize_and_overwrite(total, [&](char* buf, size_t) {
+            char* pos = buf;
+            for (size_t k = 0; k < items.size(); ++k) {
+                if (k != 0) {
+                    std::memcpy(pos, del.data(), del.size());
+                    pos += del.size();
                 }
-            }
-
-            else if (std::holds_alternative<double>(i)){
-                try {
-                    string += std::to_string(std::get<double>(i));
-                } catch(...) {
-                    string += *del;
-                    continue;
+                if (auto s = std::get_if<std::shared_ptr<std::string>>(&items[k])) {
+                    std::memcpy(pos, (*s)->data(), (*s)->size());
+                    pos += (*s)->size();
+                } else {
+                    pos = format_scalar(items[k], pos, buf + total);
                 }
             }
+            return total;
+        });
 
-            else if (std::holds_alternative<bool>(i)){
-                try {
-                    string += std::to_string(std::get<bool>(i));
-                } catch(...) {
-                    string += *del;
-                    continue;
-                }
-            }
-
-            if(count != v->items.size()) string += *del;
-        }
-
-        return std::make_shared<std::string>(string);
+        return make_string(std::move(result));
     }
 
     throw std::runtime_error("join() arguments must be a 1st: list, 2nd: string");
@@ -915,6 +1081,7 @@ Value ReplaceNode::get(SymbolTable& symbols, std::ostream& out) {
     Value ve = expr->get(symbols, out);
     Value vo = old->get(symbols, out);
     Value vn = new_s->get(symbols, out);
+    TraceScope trace(current_context(), "replace", "builtin");
 
     if (!std::holds_alternative<std::shared_ptr<std::string>>(ve) ||
         !std::holds_alternative<std::shared_ptr<std::string>>(vo) ||
@@ -930,20 +1097,7 @@ Value ReplaceNode::get(SymbolTable& symbols, std::ostream& out) {
         return original;
     }
 
-    std::string result;
-    size_t pos = 0;
-    while (true) {
-        size_t found = original->find(*from, pos);
-        if (found == std::string::npos) {
-            result.append(*original, pos, std::string::npos);
-            break;
-        }
-        result.append(*original, pos, found - pos);
-        result += *to;
-        pos = found + from->size();
-    }
-
-    return std::make_shared<std::string>(result);
+    return make_string(replace_all(*original, *from, *to));
 }
 
 Value PushNode::get(SymbolTable& symbols, std::ostream& out) {
@@ -955,6 +1109,7 @@ Value PushNode::get(SymbolTable& symbols, std::ostream& out) {
     }
     auto& lst_ptr = std::get<std::shared_ptr<ListValue>>(lv);
 
+    charge_items(1);
     lst_ptr->items.push_back(std::move(v));
 
     return Nil{};
@@ -975,6 +1130,7 @@ Value PopNode::get(SymbolTable& symbols, std::ostream& out) {
 
 Value SortNode::get(SymbolTable& symbols, std::ostream& out) {
     Value lv = expr->get(symbols, out);
+    TraceScope trace(current_context(), "sort", "builtin");
     if (!std::holds_alternative<std::shared_ptr<ListValue>>(lv))
         throw std::runtime_error("sort() argument must be a list");
 
@@ -1041,17 +1197,18 @@ Value InsertNode::get(SymbolTable& symbols, std::ostream& out) {
     if (idx < 0 || idx > (int)vec.size())
         throw std::runtime_error("insert() index out of range");
 
+    charge_items(1);
     vec.insert(vec.begin() + idx, std::move(vv));
     return Nil{};
 }
 
 Value WhileNode::get(SymbolTable& symbols, std::ostream& out) {
+    ExecutionContext& context = current_context();
     Value cond_val = condition->get(symbols, out);
     while (is_truthy(cond_val)) {
+        context.step();
         try {
-            for (auto& stmt : body) {
-                stmt->get(symbols, out);
-            }
+            if (!run_block(body, symbols, out, context)) return Nil{};
         } catch (const ContinueException&) {
             continue;
         } catch (const BreakException&) {
@@ -1066,18 +1223,126 @@ Value WhileNode::get(SymbolTable& symbols, std::ostream& out) {
 ReturnNode::ReturnNode(std::unique_ptr<ASTNode> e) : expr(std::move(e)) {}
 Value ReturnNode::get(SymbolTable& symbols, std::ostream& out) {
     Value v = expr->get(symbols, out);
-    throw ReturnException(std::move(v));
+    ExecutionContext& context = current_context();
+    if (context.control == Control::None) {
+        context.return_value = std::move(v);
+        context.control = Control::Return;
+    }
+    return Nil{};
+}
+
+Value BreakNode::get(SymbolTable&, std::ostream&) {
+    current_context().count(RunStats::Exceptions);
+    throw BreakException();
+}
+
+Value ContinueNode::get(SymbolTable&, std::ostream&) {
+    current_context().count(RunStats::Exceptions);
+    throw ContinueException();
 }
 
 FunctionNode::FunctionNode(std::vector<std::string> p,
                            std::vector<std::shared_ptr<ASTNode>> b)
-    : params(std::move(p)), body(std::move(b)) {}
+    : descriptor(std::make_shared<FunctionDescriptor>()) {
+    descriptor->params = std::move(p);
+    descriptor->body = std::move(b);
+}
 
 Value FunctionNode::get(SymbolTable& symbols, std::ostream& out) {
-    FunctionValue fv;
-    fv.params = params;
-    fv.body   = body;
-    return fv;
+    if (descriptor->captured.empty()) return FunctionValue{descriptor, nullptr, nullptr};
+
+    ExecutionContext& context = current_context();
+    auto upvalues = context.heap
+        ? context.heap->track(new Upvalues, HeapKind::Function, context.line)
+        : std::make_shared<Upvalues>();
+    upvalues->reserve(descriptor->captured.size());
+    for (auto& name : descriptor->captured) {
+        upvalues->emplace_back(name, symbols.capture(name));
+    }
+    return FunctionValue{descriptor, std::move(upvalues), nullptr};
+}
+
+// The scope a call runs in. Functions see their captured variables and the
+// globals; a self-contained one sees nothing, so any empty table will do.
+static SymbolTable frame_for(const FunctionValue& fv, const SymbolTable& symbols) {
+    if (fv->self_contained) return SymbolTable();
+    SymbolTable frame = symbols.call_frame(fv.upvalues);
+    if (fv->binds_self) frame.add_variable(fv->name, fv);
+    return frame;
+}
+
+// Tail calls still show up in stacktrace(), but only the most recent ones are
+// kept above the frame they started from, so a long tail-recursive loop runs
+// in constant space.
+static constexpr size_t kTailFramesKept = 16;
+
+struct TailFramesGuard {
+    std::vector<const FunctionDescriptor*>& stack;
+    size_t base;
+    ~TailFramesGuard() { stack.resize(base + 1); }
+};
+
+// Runs a function body, then every call it makes in tail position, in the
+// same C++ frame.
+static Value run_body(const FunctionValue& fv, SymbolTable& local, std::ostream& out) {
+    return maybe_grow([&]() -> Value {
+        ExecutionContext& context = current_context();
+        TailFramesGuard tail_frames{context.call_stack, context.call_stack.size() - 1};
+        const FunctionValue* function = &fv;
+        SymbolTable* scope = &local;
+        SymbolTable next_scope;
+        // Owners of the tail frames still on the call stack, oldest first.
+        std::vector<FunctionValue> tail_functions;
+
+        while (true) {
+            {
+                TraceScope trace(context, function->descriptor);
+                run_block((*function)->body, *scope, out, context);
+            }
+
+            if (context.control == Control::TailCall) {
+                PendingCall call = std::move(context.tail_call);
+                context.control = Control::None;
+                context.step();
+                context.count(RunStats::Calls);
+
+                SymbolTable frame = frame_for(call.function, *scope);
+                for (size_t i = 0; i < call.args.size(); ++i) {
+                    frame.add_variable(call.function->params[i], std::move(call.args[i]));
+                }
+                next_scope = std::move(frame);
+                auto& stack = context.call_stack;
+                if (stack.size() - tail_frames.base >= kTailFramesKept) {
+                    stack.erase(stack.begin() + tail_frames.base + 1);
+                    tail_functions.erase(tail_functions.begin());
+                }
+                stack.push_back(call.function.descriptor.get());
+                tail_functions.push_back(std::move(call.function));
+                function = &tail_functions.back();
+                scope = &next_scope;
+                continue;
+            }
+
+            if (context.control == Control::Return) {
+                context.control = Control::None;
+                return std::move(context.return_value);
+            }
+            return Nil{};
+        }
+    });
+}
+
+// Returns the cached result of a memoized function for these arguments, or
+// runs `call` and remembers what it returned.
+template <typename Call>
+static Value with_memo(const FunctionValue& fv, const Value* args, size_t count, Call&& call) {
+    if (!fv.memo) return call();
+    std::string key;
+    if (!MemoTable::make_key(args, count, key)) return call();
+    if (auto cached = fv.memo->find(key)) return std::move(*cached);
+    Value result = call();
+    fv.memo->insert(std::move(key), result);
+    return result;
 }
 
 CallNode::CallNode(std::unique_ptr<ASTNode> f,
@@ -1092,31 +1357,271 @@ Value CallNode::get(SymbolTable& symbols, std::ostream& out) {
     }
     FunctionValue fv = std::get<FunctionValue>(std::move(fval));
 
-    std::string fname = "<anon>";
-    if (auto var = dynamic_cast<VariableNode*>(funcExpr.get())) {
-        fname = var->get_name();
+    // A memoized callee has to see its result, so it is never tail called.
+    if (tail && !fv.memo) {
+        if (args.size() != fv->params.size()) {
+            throw std::runtime_error("Function called with wrong number of arguments");
+        }
+
+        PendingCall call{std::move(fv), {}};
+        call.args.reserve(args.size());
+        for (auto& arg : args) {
+            call.args.push_back(arg->get(symbols, out));
+        }
+
+        ExecutionContext& context = current_context();
+        context.tail_call = std::move(call);
+        context.control = Control::TailCall;
+        return Nil{};
     }
-    CallStackGuard guard(std::move(fname));
 
-    if (args.size() != fv.params.size()) {
+    CallStackGuard guard(fv.descriptor.get());
+
+    if (args.size() != fv->params.size()) {
         throw std::runtime_error("Function called with wrong number of arguments");
     }
 
-    SymbolTable local = symbols.create_child();
+    if (fv.memo) {
+        std::vector<Value> values;
+        values.reserve(args.size());
+        for (auto& arg : args) {
+            values.push_back(arg->get(symbols, out));
+        }
+        return with_memo(fv, values.data(), values.size(), [&] {
+            SymbolTable local = frame_for(fv, symbols);
+            for (size_t i = 0; i < values.size(); ++i) {
+                local.add_variable(fv->params[i], values[i]);
+            }
+            return run_body(fv, local, out);
+        });
+    }
+
+    SymbolTable local = frame_for(fv, symbols);
     for (size_t i = 0; i < args.size(); ++i) {
         Value aval = args[i]->get(symbols, out);
-        local.add_variable(fv.params[i], std::move(aval));
+        local.add_variable(fv->params[i], std::move(aval));
+    }
+
+    return run_body(fv, local, out);
+}
+
+static constexpr size_t kParallelThreshold = 4096;
+
+static FunctionValue function_arg(const Value& v, size_t arity, const char* fn) {
+    if (!std::holds_alternative<FunctionValue>(v))
+        throw std::runtime_error(std::string(fn) + " argument must be a function");
+    const FunctionValue& fv = std::get<FunctionValue>(v);
+    if (fv->params.size() != arity) {
+        throw std::runtime_error("Function called with wrong number of arguments");
     }
+    return fv;
+}
 
-    try {
-        for (auto& stmt_ptr : fv.body) {
-            stmt_ptr->get(local, out);
+static std::shared_ptr<ListValue> list_arg(const Value& v, const char* fn) {
+    if (!std::holds_alternative<std::shared_ptr<ListValue>>(v))
+        throw std::runtime_error(std::string(fn) + " 1st argument must be a list");
+    return std::get<std::shared_ptr<ListValue>>(v);
+}
+
+static size_t chunk_count(const FunctionValue& fv, size_t count, bool always_parallel) {
+    if (!fv->self_contained || count < 2) return 1;
+    if (!always_parallel && count < kParallelThreshold) return 1;
+    return std::min<size_t>(current_context().threads, count);
+}
+
+// Splits [0, count) into chunks and runs them on the shared pool, the calling
+// thread taking the first one and then helping with whatever is still queued.
+// Every chunk, the caller's included, runs under its own ExecutionContext, and
+// all of them draw on the caller's budget through one SharedUsage; what they
+// used is added to the caller's counters once they are done. The error of the
+// earliest failing chunk is rethrown here.
+static void run_chunks(size_t count, size_t chunks, const std::function<void(size_t, size_t)>& body) {
+    ThreadPool& pool = ThreadPool::shared();
+    ExecutionContext& caller = current_context();
+    std::vector<std::exception_ptr> errors(chunks);
+    std::atomic<size_t> remaining(chunks - 1);
+    SharedUsage usage;
+    // Chunks start from the caller's frames so stacktrace() and profiles
+    // taken inside fn look the same as on the caller's thread.
+    const std::vector<const FunctionDescriptor*> frames = caller.call_stack;
+
+    auto run = [&](size_t chunk) {
+        ExecutionContext context;
+        context.inherit_limits(caller, usage);
+        context.call_stack = frames;
+        ContextScope scope(context);
+        try {
+            body(count * chunk / chunks, count * (chunk + 1) / chunks);
+        } catch (...) {
+            errors[chunk] = std::current_exception();
         }
-    } catch (const ReturnException& rex) {
-        return rex.value;
+        context.flush_usage();
+        context.flush_coverage();
+    };
+
+    for (size_t chunk = 1; chunk < chunks; ++chunk) {
+        pool.submit([&run, &remaining, chunk] {
+            run(chunk);
+            remaining.fetch_sub(1, std::memory_order_release);
+        });
     }
+    run(0);
 
-    return Nil{};
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (!pool.run_pending()) std::this_thread::yield();
+    }
+
+    for (auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+    caller.absorb(usage);
+}
+
+Value MapNode::get(SymbolTable& symbols, std::ostream& out) {
+    auto source = list_arg(list->get(symbols, out), "map()");
+    FunctionValue fv = function_arg(fn->get(symbols, out), 1, "map()");
+    const FunctionDescriptor* callee = fv.descriptor.get();
+    TraceScope trace(current_context(), always_parallel ? "pmap" : "map", "builtin");
+
+    charge_items(source->items.size());
+    auto result = make_list();
+    size_t chunks = chunk_count(fv, source->items.size(), always_parallel);
+
+    if (chunks == 1) {
+        for (size_t i = 0; i < source->items.size(); ++i) {
+            CallStackGuard guard(callee);
+            result->items.push_back(with_memo(fv, &source->items[i], 1, [&] {
+                SymbolTable local = frame_for(fv, symbols);
+                local.add_variable(fv->params[0], source->items[i]);
+                return run_body(fv, local, out);
+            }));
+        }
+        return result;
+    }
+
+    result->items.resize(source->items.size());
+    run_chunks(source->items.size(), chunks, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            CallStackGuard guard(callee);
+            result->items[i] = with_memo(fv, &source->items[i], 1, [&] {
+                SymbolTable local;
+                local.add_variable(fv->params[0], source->items[i]);
+                return run_body(fv, local, out);
+            });
+        }
+    });
+    return result;
+}
+
+Value FilterNode::get(SymbolTable& symbols, std::ostream& out) {
+    auto source = list_arg(list->get(symbols, out), "filter()");
+    FunctionValue fv = function_arg(fn->get(symbols, out), 1, "filter()");
+    const FunctionDescriptor* callee = fv.descriptor.get();
+    TraceScope trace(current_context(), "filter", "builtin");
+
+    auto result = make_list();
+    size_t chunks = chunk_count(fv, source->items.size(), false);
+
+    if (chunks == 1) {
+        for (size_t i = 0; i < source->items.size(); ++i) {
+            CallStackGuard guard(callee);
+            const Value& item = source->items[i];
+            Value keep = with_memo(fv, &item, 1, [&] {
+                SymbolTable local = frame_for(fv, symbols);
+                local.add_variable(fv->params[0], item);
+                return run_body(fv, local, out);
+            });
+            if (is_truthy(keep)) {
+                charge_items(1);
+                result->items.push_back(item);
+            }
+        }
+        return result;
+    }
+
+    std::vector<char> keep(source->items.size());
+    run_chunks(source->items.size(), chunks, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            CallStackGuard guard(callee);
+            keep[i] = is_truthy(with_memo(fv, &source->items[i], 1, [&] {
+                SymbolTable local;
+                local.add_variable(fv->params[0], source->items[i]);
+                return run_body(fv, local, out);
+            }));
+        }
+    });
+
+    charge_items(std::count(keep.begin(), keep.end(), 1));
+    for (size_t i = 0; i < keep.size(); ++i) {
+        if (keep[i]) result->items.push_back(source->items[i]);
+    }
+    return result;
+}
+
+Value ReduceNode::get(SymbolTable& symbols, std::ostream& out) {
+    auto source = list_arg(list->get(symbols, out), "reduce()");
+    FunctionValue fv = function_arg(fn->get(symbols, out), 2, "reduce()");
+    const FunctionDescriptor* callee = fv.descriptor.get();
+    TraceScope trace(current_context(), "reduce", "builtin");
+
+    Value acc = init->get(symbols, out);
+    for (size_t i = 0; i < source->items.size(); ++i) {
+        CallStackGuard guard(callee);
+        Value pair[2] = {std::move(acc), source->items[i]};
+        acc = with_memo(fv, pair, 2, [&] {
+            SymbolTable local = frame_for(fv, symbols);
+            local.add_variable(fv->params[0], std::move(pair[0]));
+            local.add_variable(fv->params[1], std::move(pair[1]));
+            return run_body(fv, local, out);
+        });
+    }
+    return acc;
+}
+
+Value MemoizeNode::get(SymbolTable& symbols, std::ostream& out) {
+    Value fval = fn->get(symbols, out);
+    if (!std::holds_alternative<FunctionValue>(fval))
+        throw std::runtime_error("memoize() expects a function");
+    size_t capacity = current_context().memo_capacity;
+    if (size) {
+        Value sval = size->get(symbols, out);
+        if (!std::holds_alternative<int>(sval) || std::get<int>(sval) <= 0)
+            throw std::runtime_error("memoize() cache size must be a positive int");
+        capacity = std::get<int>(sval);
+    }
+    FunctionValue memoized = std::get<FunctionValue>(std::move(fval));
+    ExecutionContext& context = current_context();
+    memoized.memo = context.heap
+        ? context.heap->track(new MemoTable(capacity), HeapKind::Function, context.line)
+        : std::make_shared<MemoTable>(capacity);
+    return memoized;
+}
+
+Value MemoStatsNode::get(SymbolTable& symbols, std::ostream& out) {
+    Value fval = fn->get(symbols, out);
+    if (!std::holds_alternative<FunctionValue>(fval) || !std::get<FunctionValue>(fval).memo)
+        throw std::runtime_error("memo_stats() expects a memoized function");
+    MemoStats stats = std::get<FunctionValue>(fval).memo->stats();
+    auto list = make_list();
+    list->items = {static_cast<int>(stats.hits), static_cast<int>(stats.misses), static_cast<int>(stats.size)};
+    return list;
+}
+
+// Counters can pass INT_MAX on long runs; those are returned as doubles
+// rather than wrapped to negative ints.
+static Value counter_value(uint64_t n) {
+    if (n <= static_cast<uint64_t>(INT_MAX)) return static_cast<int>(n);
+    return static_cast<double>(n);
+}
+
+Value StatsNode::get(SymbolTable&, std::ostream&) {
+    const RunStats* stats = current_context().stats;
+    if (!stats) throw std::runtime_error("run_stats() needs run statistics to be enabled");
+    auto list = make_list();
+    for (size_t i = 0; i < RunStats::kCounters; ++i) {
+        list->items.push_back(counter_value(stats->get(static_cast<RunStats::Counter>(i))));
+    }
+    return list;
 }
 
 static int to_int(const Value& v) {
@@ -1128,7 +1633,8 @@ static int to_int(const Value& v) {
 }
 
 Value ListNode::get(SymbolTable& symbols, std::ostream& out) {
-    auto list = std::make_shared<ListValue>();
+    charge_items(elements.size());
+    auto list = make_list();
     for (auto& elem : elements) {
         list->items.push_back(elem->get(symbols, out));
     }
@@ -1156,7 +1662,7 @@ Value IndexNode::get(SymbolTable& symbols, std::ostream& out) {
         const auto& s = std::get<std::shared_ptr<std::string>>(container_val);
         if (idx < 0 || idx >= static_cast<int>(s->size()))
             throw std::runtime_error("String index out of range");
-        return std::make_shared<std::string>(1, (*s)[idx]);
+        return make_string(1, (*s)[idx]);
     }
 
     throw std::runtime_error("Indexing non-list/string value");
@@ -1173,7 +1679,8 @@ Value SliceNode::get(SymbolTable& symbols, std::ostream& out) {
         if (start_idx < 0) start_idx = 0;
         if (end_idx > (int)lst->items.size()) end_idx = lst->items.size();
         if (start_idx > end_idx) start_idx = end_idx;
-        auto slice = std::make_shared<ListValue>();
+        charge_items(end_idx - start_idx);
+        auto slice = make_list();
         for (int i = start_idx; i < end_idx; ++i) {
             slice->items.push_back(lst->items[i]);
         }
@@ -1185,7 +1692,15 @@ Value SliceNode::get(SymbolTable& symbols, std::ostream& out) {
         if (start_idx < 0) start_idx = 0;
         if (end_idx > (int)s->size()) end_idx = s->size();
         if (start_idx > end_idx) start_idx = end_idx;
-        return std::make_shared<std::string>(s->substr(start_idx, end_idx - start_idx));
+        return make_string(s->substr(start_idx, end_idx - start_idx));
     }
     throw std::runtime_error("Slicing non-list/string value");
 }
+
+Value StackTraceNode::get(SymbolTable&, std::ostream&) {
+    auto list = make_list();
+    for (const FunctionDescriptor* fn : current_context().call_stack) {
+        list->items.push_back(make_string(fn->name));
+    }
+    return list;
+}
@@ -1,8 +1,13 @@
 #pragma once
 #include "tokens/tokens.h"
-#include "interpreter/call_stack.h"
+#include <functional>
+#include <cstdint>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -10,6 +15,7 @@ struct ASTNode;
 struct ListValue;
 struct Nil;
 struct FunctionValue;  
+class MemoTable;
 
 struct Nil { };
 
@@ -23,9 +29,38 @@ using Value = std::variant<
     Nil
 >;
 
-struct FunctionValue {
+// Everything about a function literal that is known at parse time. Function
+// values and call stack frames point at it instead of copying it.
+struct FunctionDescriptor {
+    // The variable the literal is assigned to, if any.
+    std::string name = "<anon>";
     std::vector<std::string> params;
     std::vector<std::shared_ptr<ASTNode>> body;
+    // Names read from enclosing scopes.
+    std::vector<std::string> free_variables;
+    // The free variables that are locals of an enclosing function rather
+    // than globals. Their cells are captured when the literal is evaluated.
+    std::vector<std::string> captured;
+    // The function refers to itself through the local it is assigned to.
+    // Calls bind that name to the function being called instead of
+    // capturing it, which would make the value own itself.
+    bool binds_self = false;
+    // Reads nothing but its parameters and locals and has no side effects,
+    // so calls may run on any thread with an empty symbol table.
+    bool self_contained = false;
+};
+
+// Variables a closure shares with the calls that created it.
+using Upvalues = std::vector<std::pair<std::string, std::shared_ptr<Value>>>;
+
+struct FunctionValue {
+    std::shared_ptr<const FunctionDescriptor> descriptor;
+    // One cell per descriptor->captured name, in the same order.
+    std::shared_ptr<const Upvalues> upvalues;
+    // Set on values returned by memoize().
+    std::shared_ptr<MemoTable> memo;
+
+    const FunctionDescriptor* operator->() const { return descriptor.get(); }
 
     bool operator==(const FunctionValue& other) { return false; }
     bool operator!=(const FunctionValue& other) { return false; }
@@ -38,16 +73,37 @@ struct ListValue {
 };
 
 class SymbolTable {
+    // Scopes form a chain from the innermost one outwards. A child table
+    // only ever writes to its own innermost scope, so it can share the
+    // enclosing ones with its parent instead of copying them. A function
+    // call gets a single scope whose parent is the global one.
     struct Scope {
         std::unordered_map<std::string, Value> variables;
+        // Locals of this call that a nested function has captured. They
+        // are moved here from `variables` the first time that happens.
+        std::unordered_map<std::string, std::shared_ptr<Value>> cells;
+        // Variables of enclosing calls captured by the running function.
+        std::shared_ptr<const Upvalues> upvalues;
+        std::shared_ptr<Scope> parent;
+
+        const std::shared_ptr<Value>* find_cell(const std::string& name) const;
     };
-    std::vector<Scope> scopes;
+    std::shared_ptr<Scope> scope;
 
 public:
     SymbolTable();
 
     SymbolTable create_child();
 
+    // The scope for a call: a fresh innermost scope seeing the function's
+    // captured variables and the globals, but not the caller's locals.
+    SymbolTable call_frame(std::shared_ptr<const Upvalues> upvalues) const;
+
+    // The cell holding `name` in the innermost scope, boxing the variable
+    // if it is not shared yet. A name not assigned so far gets a nil cell
+    // that later assignments write to.
+    std::shared_ptr<Value> capture(const std::string& name);
+
     void add_variable(const std::string& name, Value value);
 
     Value get_variable(const std::string& name) const ;
@@ -58,40 +114,92 @@ public:
 
 };
 
-inline SymbolTable::SymbolTable() {
-        scopes.emplace_back();
-}
+inline SymbolTable::SymbolTable() : scope(std::make_shared<Scope>()) {}
     
 inline void SymbolTable::push_scope() {
-    scopes.emplace_back();
+    auto inner = std::make_shared<Scope>();
+    inner->parent = std::move(scope);
+    scope = std::move(inner);
 }
     
 inline void SymbolTable::pop_scope() {
-    if (scopes.size() > 1) {
-        scopes.pop_back();
+    if (scope->parent) {
+        scope = scope->parent;
     }
 }
 
+inline const std::shared_ptr<Value>* SymbolTable::Scope::find_cell(const std::string& name) const {
+    if (!cells.empty()) {
+        auto found = cells.find(name);
+        if (found != cells.end()) return &found->second;
+    }
+    if (upvalues) {
+        for (auto& [captured, cell] : *upvalues) {
+            if (captured == name) return &cell;
+        }
+    }
+    return nullptr;
+}
+
 inline void SymbolTable::add_variable(const std::string& name, Value value) {
-    scopes.back().variables[name] = value;
+    if (auto cell = scope->find_cell(name)) {
+        **cell = std::move(value);
+        return;
+    }
+    scope->variables[name] = std::move(value);
 }
 
 inline Value SymbolTable::get_variable(const std::string& name) const {
-    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
-        if (it->variables.count(name)) return it->variables.at(name);
+    for (const Scope* it = scope.get(); it; it = it->parent.get()) {
+        auto found = it->variables.find(name);
+        if (found != it->variables.end()) return found->second;
+        if (auto cell = it->find_cell(name)) return **cell;
     }
     throw std::runtime_error("Undefined variable: " + name);
 }
 
+inline SymbolTable SymbolTable::call_frame(std::shared_ptr<const Upvalues> upvalues) const {
+    std::shared_ptr<Scope> globals = scope;
+    while (globals->parent) globals = globals->parent;
+    SymbolTable frame;
+    frame.scope->upvalues = std::move(upvalues);
+    frame.scope->parent = std::move(globals);
+    return frame;
+}
+
+inline std::shared_ptr<Value> SymbolTable::capture(const std::string& name) {
+    if (auto cell = scope->find_cell(name)) return *cell;
+    auto cell = std::make_shared<Value>(Nil{});
+    auto found = scope->variables.find(name);
+    if (found != scope->variables.end()) {
+        *cell = std::move(found->second);
+        scope->variables.erase(found);
+    }
+    scope->cells.emplace(name, cell);
+    return cell;
+}
+
 inline SymbolTable SymbolTable::create_child() {
-    SymbolTable child;
-    child.scopes = this->scopes; 
+    SymbolTable child(*this);
     child.push_scope();
     return child;
 }
 
+// An error raised by a statement, tagged with the line the statement starts
+// on. Thrown by the parser and by statement lists; other code keeps
+// throwing plain runtime errors.
+struct LocatedError : std::runtime_error {
+    uint32_t line;
+    LocatedError(const std::string& message, uint32_t l) : std::runtime_error(message), line(l) {}
+};
+
 class ASTNode {
 public:
+    // Where the statement starts in the source. Only set on statements;
+    // expressions do not span lines, so their statement's line is theirs.
+    uint32_t line = 0;
+    uint32_t column = 0;
+
     virtual ~ASTNode() = default;
     virtual Value get(SymbolTable& symbols, std::ostream& out) = 0;
 };
@@ -166,12 +274,42 @@ public:
 };
 
 class ReadNode : public ASTNode {
-    std::string expr;
 public:
     ReadNode();
     Value get(SymbolTable& symbols, std::ostream& out) override;
 };
 
+class LinesNode : public ASTNode {
+    std::unique_ptr<ASTNode> path;
+public:
+    LinesNode() {}
+    LinesNode(std::unique_ptr<ASTNode> p) : path(std::move(p)) {}
+    Value get(SymbolTable& symbols, std::ostream& out) override;
+    void for_each_line(SymbolTable& symbols, std::ostream& out, const std::function<bool(std::string_view)>& fn);
+};
+
+// read_file(path[, offset[, count]]) and file_bytes(...) take the whole file
+// or the `count` bytes from `offset`, so large files can be walked in windows.
+class ReadFileNode : public ASTNode {
+    std::unique_ptr<ASTNode> path;
+    std::unique_ptr<ASTNode> offset;
+    std::unique_ptr<ASTNode> count;
+public:
+    ReadFileNode(std::unique_ptr<ASTNode> p, std::unique_ptr<ASTNode> o, std::unique_ptr<ASTNode> c)
+        : path(std::move(p)), offset(std::move(o)), count(std::move(c)) {}
+    Value get(SymbolTable& symbols, std::ostream& out) override;
+};
+
+class FileBytesNode : public ASTNode {
+    std::unique_ptr<ASTNode> path;
+    std::unique_ptr<ASTNode> offset;
+    std::unique_ptr<ASTNode> count;
+public:
+    FileBytesNode(std::unique_ptr<ASTNode> p, std::unique_ptr<ASTNode> o, std::unique_ptr<ASTNode> c)
+        : path(std::move(p)), offset(std::move(o)), count(std::move(c)) {}
+    Value get(SymbolTable& symbols, std::ostream& out) override;
+};
+
 class IfNode : public ASTNode {
 public:
     struct ElseIfBranch {
@@ -195,9 +333,9 @@ public:
 };
 
 class StringNode : public ASTNode {
-    std::string value;
+    std::shared_ptr<std::string> value;
 public:
-    StringNode(const std::string& val);
+    StringNode(std::shared_ptr<std::string> val);
     Value get(SymbolTable&, std::ostream&) override;
 };
 
@@ -220,6 +358,7 @@ class ForNode : public ASTNode {
     std::unique_ptr<ASTNode> end_expr;
     std::unique_ptr<ASTNode> step_expr;
     std::unique_ptr<ASTNode> iterable_expr;
+    std::unique_ptr<LinesNode> lines_expr;
     std::vector<std::unique_ptr<ASTNode>> body;
 
 public:
@@ -241,6 +380,13 @@ public:
           iterable_expr(std::move(iterable_node)),
           body(std::move(body_nodes)) {}
 
+    ForNode(std::string var,
+            std::unique_ptr<LinesNode> lines_node,
+            std::vector<std::unique_ptr<ASTNode>> body_nodes)
+        : var_name(std::move(var)),
+          lines_expr(std::move(lines_node)),
+          body(std::move(body_nodes)) {}
+
     Value get(SymbolTable& symbols, std::ostream& out) override;
 };
 
@@ -335,6 +481,35 @@ public:
     Value get(SymbolTable& symbols, std::ostream& out) override;
 };
 
+class IsDigitNode : public ASTNode {
+    std::unique_ptr<ASTNode> expr;
+public:
+    IsDigitNode(std::unique_ptr<ASTNode> e) : expr(std::move(e)) {}
+    Value get(SymbolTable& symbols, std::ostream& out) override;
+};
+
+class IsAlphaNode : public ASTNode {
+    std::unique_ptr<ASTNode> expr;
+public:
+    IsAlphaNode(std::unique_ptr<ASTNode> e) : expr(std::move(e)) {}
+    Value get(SymbolTable& symbols, std::ostream& out) override;
+};
+
+class TrimNode : public ASTNode {
+    std::unique_ptr<ASTNode> expr;
+public:
+    TrimNode(std::unique_ptr<ASTNode> e) : expr(std::move(e)) {}
+    Value get(SymbolTable& symbols, std::ostream& out) override;
+};
+
+class CountNode : public ASTNode {
+    std::unique_ptr<ASTNode> expr;
+    std::unique_ptr<ASTNode> needle;
+public:
+    CountNode(std::unique_ptr<ASTNode> e, std::unique_ptr<ASTNode> n) : expr(std::move(e)), needle(std::move(n)) {}
+    Value get(SymbolTable& symbols, std::ostream& out) override;
+};
+
 class SplitNode : public ASTNode {
     std::unique_ptr<ASTNode> expr;
     std::unique_ptr<ASTNode> delim;
@@ -360,6 +535,58 @@ public:
     Value get(SymbolTable& symbols, std::ostream& out) override;
 };
 
+// map(list, fn) and pmap(list, fn). Self-contained functions are applied
+// on the worker pool: map does so for large lists only, pmap always.
+class MapNode : public ASTNode {
+    std::unique_ptr<ASTNode> list;
+    std::unique_ptr<ASTNode> fn;
+    bool always_parallel;
+public:
+    MapNode(std::unique_ptr<ASTNode> l, std::unique_ptr<ASTNode> f, bool p) : list(std::move(l)), fn(std::move(f)), always_parallel(p) {}
+    Value get(SymbolTable& symbols, std::ostream& out) override;
+};
+
+class FilterNode : public ASTNode {
+    std::unique_ptr<ASTNode> list;
+    std::unique_ptr<ASTNode> fn;
+public:
+    FilterNode(std::unique_ptr<ASTNode> l, std::unique_ptr<ASTNode> f) : list(std::move(l)), fn(std::move(f)) {}
+    Value get(SymbolTable& symbols, std::ostream& out) override;
+};
+
+class ReduceNode : public ASTNode {
+    std::unique_ptr<ASTNode> list;
+    std::unique_ptr<ASTNode> fn;
+    std::unique_ptr<ASTNode> init;
+public:
+    ReduceNode(std::unique_ptr<ASTNode> l, std::unique_ptr<ASTNode> f, std::unique_ptr<ASTNode> i) : list(std::move(l)), fn(std::move(f)), init(std::move(i)) {}
+    Value get(SymbolTable& symbols, std::ostream& out) override;
+};
+
+// memoize(fn) and memoize(fn, size): a copy of fn that caches its results.
+class MemoizeNode : public ASTNode {
+    std::unique_ptr<ASTNode> fn;
+    std::unique_ptr<ASTNode> size;
+public:
+    MemoizeNode(std::unique_ptr<ASTNode> f, std::unique_ptr<ASTNode> s) : fn(std::move(f)), size(std::move(s)) {}
+    Value get(SymbolTable& symbols, std::ostream& out) override;
+};
+
+// memo_stats(fn): [hits, misses, size] of a memoized function's cache.
+class MemoStatsNode : public ASTNode {
+    std::unique_ptr<ASTNode> fn;
+public:
+    MemoStatsNode(std::unique_ptr<ASTNode> f) : fn(std::move(f)) {}
+    Value get(SymbolTable& symbols, std::ostream& out) override;
+};
+
+// run_stats(): [lookups, string allocations, list allocations, calls,
+// exceptions] counted so far by the interpreter's stats collector.
+class StatsNode : public ASTNode {
+public:
+    Value get(SymbolTable& symbols, std::ostream& out) override;
+};
+
 class PushNode : public ASTNode {
     std::unique_ptr<ASTNode> list;
     std::unique_ptr<ASTNode> expr;
@@ -412,8 +639,9 @@ public:
 
 class FunctionNode : public ASTNode {
 public:
-    std::vector<std::string> params;
-    std::vector<std::shared_ptr<ASTNode>> body;
+    // Shared by every value this literal evaluates to. The parser fills in
+    // the name, free variables and purity once the body has been read.
+    std::shared_ptr<FunctionDescriptor> descriptor;
 
     FunctionNode(std::vector<std::string> p,
                  std::vector<std::shared_ptr<ASTNode>> b);
@@ -425,6 +653,9 @@ class CallNode : public ASTNode {
 public:
     std::unique_ptr<ASTNode> funcExpr;
     std::vector<std::unique_ptr<ASTNode>> args;
+    // Set by the parser for `return f(...)`: the call replaces the frame of
+    // the function it is returned from instead of nesting inside it.
+    bool tail = false;
 
     CallNode(std::unique_ptr<ASTNode> f,
              std::vector<std::unique_ptr<ASTNode>> a);
@@ -438,27 +669,18 @@ public:
     Value get(SymbolTable& symbols, std::ostream& out) override;
 };
 
-struct ReturnException {
-    Value value;
-    ReturnException(Value v) : value(std::move(v)) {}
-};
-
 struct BreakException {};
 
 class BreakNode : public ASTNode {
 public:
-    Value get(SymbolTable&, std::ostream&) override {
-        throw BreakException();
-    }
+    Value get(SymbolTable&, std::ostream&) override;
 };
 
 struct ContinueException {};
 
 class ContinueNode : public ASTNode {
 public:
-    Value get(SymbolTable&, std::ostream&) override {
-        throw ContinueException();
-    }
+    Value get(SymbolTable&, std::ostream&) override;
 };
 
 inline bool is_truthy(const Value& val) {
@@ -512,11 +734,5 @@ public:
 class StackTraceNode : public ASTNode {
 public:
     StackTraceNode () {}
-    Value get(SymbolTable&, std::ostream&) override {
-        auto list = std::make_shared<ListValue>();
-        for (auto& fn : call_stack) {
-            list->items.push_back(std::make_shared<std::string>(fn));
-        }
-        return list;
-    }
+    Value get(SymbolTable&, std::ostream&) override;
 };
\ No newline at end of file
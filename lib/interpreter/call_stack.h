@@ -1,10 +1,42 @@
 #pragma once
-#include <vector>
-#include <string>
-
-inline std::vector<std::string> call_stack;
+#include "interpreter/context.h"
 
 struct CallStackGuard {
-    CallStackGuard(std::string fn) { call_stack.push_back(std::move(fn)); }
-    ~CallStackGuard() { call_stack.pop_back(); }
-};
\ No newline at end of file
+    ExecutionContext& context;
+    CallStackGuard(const FunctionDescriptor* fn) : context(current_context()) {
+        context.enter_call();
+        context.call_stack.push_back(fn);
+    }
+    ~CallStackGuard() { context.call_stack.pop_back(); }
+};
+
+// Records the time from construction to destruction as one trace event when
+// the run is traced; otherwise does nothing.
+class TraceScope {
+    ExecutionContext& context;
+    TraceEvent event;
+
+public:
+    TraceScope(ExecutionContext& context, const char* name, const char* category) : context(context) {
+        if (!context.tracer) return;
+        event.name = std::shared_ptr<const char>(std::shared_ptr<const char>(), name);
+        event.category = category;
+        event.start = context.tracer->now();
+    }
+
+    TraceScope(ExecutionContext& context, const std::shared_ptr<const FunctionDescriptor>& fn) : context(context) {
+        if (!context.tracer) return;
+        event.name = std::shared_ptr<const char>(fn, fn->name.c_str());
+        event.category = "function";
+        event.start = context.tracer->now();
+    }
+
+    ~TraceScope() {
+        if (!event.name) return;
+        event.duration = context.tracer->now() - event.start;
+        context.trace(std::move(event));
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
@@ -0,0 +1,110 @@
+#include "context.h"
+
+void ExecutionContext::start_run() {
+    control = Control::None;
+    steps = 0;
+    alloc_bytes = 0;
+    deadline = budget.timeout.count() > 0
+        ? std::chrono::steady_clock::now() + budget.timeout
+        : std::chrono::steady_clock::time_point::max();
+    last_sample = std::chrono::steady_clock::now();
+    // The run may be on another thread than the previous one.
+    trace_buffer = nullptr;
+    next_batch();
+}
+
+void ExecutionContext::inherit_limits(const ExecutionContext& parent, SharedUsage& usage) {
+    budget = parent.budget;
+    shared = &usage;
+    base_steps = parent.used_steps() + (parent.batch - parent.fuel);
+    base_alloc_bytes = parent.shared ? parent.base_alloc_bytes + parent.shared->alloc_bytes.load() : parent.alloc_bytes;
+    steps = 0;
+    alloc_bytes = 0;
+    deadline = parent.deadline;
+    threads = parent.threads;
+    profiler = parent.profiler;
+    stats = parent.stats;
+    coverage = parent.coverage;
+    heap = parent.heap;
+    memo_capacity = parent.memo_capacity;
+    tracer = parent.tracer;
+    line = parent.line;
+    last_sample = std::chrono::steady_clock::now();
+    next_batch();
+}
+
+void ExecutionContext::flush_usage() {
+    int64_t partial = batch - fuel;
+    steps += partial;
+    if (shared && budget.max_steps) shared->steps += partial;
+    batch = fuel;
+}
+
+void ExecutionContext::absorb(const SharedUsage& usage) {
+    // The current batch was sized before the work was done; count what was
+    // taken of it and size the next one from the new total.
+    flush_usage();
+    uint64_t more_steps = usage.steps.load();
+    size_t more_bytes = usage.alloc_bytes.load();
+    steps += more_steps;
+    alloc_bytes += more_bytes;
+    if (shared) {
+        shared->steps += more_steps;
+        shared->alloc_bytes += more_bytes;
+    }
+    check_limits();
+    next_batch();
+}
+
+void ExecutionContext::check_limits() const {
+    if (budget.max_steps && used_steps() > budget.max_steps) {
+        throw std::runtime_error("Step limit exceeded");
+    }
+    size_t used_bytes = shared ? base_alloc_bytes + shared->alloc_bytes.load() : alloc_bytes;
+    if (budget.max_alloc_bytes && used_bytes > budget.max_alloc_bytes) {
+        throw std::runtime_error("Allocation limit exceeded");
+    }
+}
+
+void ExecutionContext::next_batch() {
+    batch = INT64_MAX;
+    if (budget.timeout.count() > 0) batch = kCheckInterval;
+    if (budget.max_steps) {
+        uint64_t used = used_steps();
+        uint64_t left = used < budget.max_steps ? budget.max_steps - used : 0;
+        batch = std::min<int64_t>(batch, left + 1);
+    }
+    if (profiler) batch = std::min<int64_t>(batch, profiler->interval());
+    fuel = batch;
+}
+
+void ExecutionContext::refuel() {
+    steps += batch;
+    if (shared && budget.max_steps) shared->steps += batch;
+    if (profiler) {
+        auto now = std::chrono::steady_clock::now();
+        profiler->sample(call_stack, line, now - last_sample);
+        last_sample = now;
+    }
+    if (budget.max_steps && used_steps() > budget.max_steps) {
+        throw std::runtime_error("Step limit exceeded");
+    }
+    if (std::chrono::steady_clock::now() >= deadline) {
+        throw std::runtime_error("Time limit exceeded");
+    }
+    next_batch();
+}
+
+InputReader& ExecutionContext::reader() {
+    if (!input) {
+        if (!input_stream) throw std::runtime_error("No input stream to read from");
+        input = std::make_unique<InputReader>(*input_stream);
+    }
+    return *input;
+}
+
+void ExecutionContext::flush_coverage() {
+    if (!coverage || line_hits.empty()) return;
+    coverage->add_hits(line_hits);
+    line_hits.clear();
+}
@@ -0,0 +1,211 @@
+#pragma once
+#include "ast/nodes.h"
+#include "interpreter/coverage.h"
+#include "interpreter/heap_profiler.h"
+#include "interpreter/memo_table.h"
+#include "interpreter/profiler.h"
+#include "interpreter/run_stats.h"
+#include "interpreter/tracer.h"
+#include "io/input_reader.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Per-run limits. Zero means unlimited.
+struct Budget {
+    uint64_t max_steps = 0;
+    size_t max_call_depth = 0;
+    // Total bytes of string and list data the script may allocate over the
+    // run. Freed values are not given back: this is a quota, not a cap on
+    // live memory.
+    size_t max_alloc_bytes = 0;
+    std::chrono::milliseconds timeout{0};
+    // Heap-allocated stack the script's recursion may grow into beyond the
+    // thread's own stack. Unlike the other limits this one is on by default.
+    size_t max_stack_bytes = size_t(1) << 30;
+};
+
+// What the contexts running the pieces of one map/filter/pmap call have used
+// between them. Only kept up while the budget limits it.
+struct SharedUsage {
+    std::atomic<uint64_t> steps{0};
+    std::atomic<size_t> alloc_bytes{0};
+};
+
+enum class Control { None, Return, TailCall };
+
+struct PendingCall {
+    FunctionValue function;
+    std::vector<Value> args;
+};
+
+struct ExecutionContext {
+    // One entry per active call. Frames only borrow the descriptor: the
+    // caller holds the function value for as long as the frame is live.
+    std::vector<const FunctionDescriptor*> call_stack;
+    // Seeded on first use: most runs never call rnd(), and seeding costs a
+    // read from the OS entropy source per context, pmap chunks included.
+    std::mt19937& rng() {
+        if (!rng_state) rng_state.emplace(std::random_device{}());
+        return *rng_state;
+    }
+    // What read() and lines() consume, made on first use from
+    // `input_stream`. The context never falls back to std::cin itself:
+    // that is up to whoever sets the stream, so the library does not pull
+    // in the standard stream objects.
+    std::unique_ptr<InputReader> input;
+    std::istream* input_stream = nullptr;
+    // Upper bound on threads used by map/filter/pmap, the caller included.
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    // Cache size of memoize(fn) called without one.
+    size_t memo_capacity = MemoTable::kDefaultCapacity;
+
+    InputReader& reader();
+
+    // Set by `return` and by calls in tail position. Statement lists stop
+    // as soon as it is not None and the enclosing call takes over.
+    Control control = Control::None;
+    Value return_value;
+    PendingCall tail_call;
+
+    Budget budget;
+    uint64_t steps = 0;
+    size_t alloc_bytes = 0;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+    // When set, the call stack and the current line are sampled every
+    // profiler->interval() steps.
+    Profiler* profiler = nullptr;
+    std::chrono::steady_clock::time_point last_sample;
+
+    // When set, lookups, allocations, calls and thrown control flow are
+    // counted into it.
+    RunStats* stats = nullptr;
+
+    void count(RunStats::Counter counter) {
+        if (stats) stats->add(counter);
+    }
+
+    // When set, statements executed are counted per line, first into
+    // line_hits and then, at flush_coverage(), into the collector.
+    Coverage* coverage = nullptr;
+    std::vector<uint64_t> line_hits;
+
+    void hit_line(uint32_t line) {
+        if (!coverage) return;
+        if (line >= line_hits.size()) line_hits.resize(line + 1);
+        ++line_hits[line];
+    }
+
+    void flush_coverage();
+
+    // Start line of the statement being run.
+    uint32_t line = 0;
+
+    // When set, strings, lists and function state the script makes are
+    // registered with it under the current line.
+    HeapProfiler* heap = nullptr;
+
+    // When set, function bodies, builtins and printing are recorded on a
+    // timeline in this thread's buffer of it.
+    Tracer* tracer = nullptr;
+
+    void trace(TraceEvent event) {
+        if (!trace_buffer) trace_buffer = &tracer->buffer();
+        trace_buffer->push(std::move(event));
+    }
+
+    // Resets the counters and starts the clock for a new run.
+    void start_run();
+
+    // Takes over the limits, the current line, the thread count, the memoize
+    // cache size, and the profiler, stats, coverage, heap and trace
+    // collectors, from the context of a run, for work split off from it.
+    // Every piece of the work shares `usage`, so together they get what is
+    // left of the parent's allowance rather than each getting all of it.
+    void inherit_limits(const ExecutionContext& parent, SharedUsage& usage);
+
+    // Adds the steps left over in the current batch to the shared usage;
+    // called when a piece of split-off work is done.
+    void flush_usage();
+
+    // Counts what the split-off work used against this context's limits.
+    void absorb(const SharedUsage& usage);
+
+    // Called at every loop iteration and call. The counters and the clock
+    // are only looked at once per batch of steps.
+    void step() {
+        if (--fuel <= 0) refuel();
+    }
+
+    void charge(size_t bytes) {
+        alloc_bytes += bytes;
+        if (!budget.max_alloc_bytes) return;
+        size_t used = shared ? base_alloc_bytes + (shared->alloc_bytes += bytes) : alloc_bytes;
+        if (used > budget.max_alloc_bytes) {
+            throw std::runtime_error("Allocation limit exceeded");
+        }
+    }
+
+    void enter_call() {
+        step();
+        count(RunStats::Calls);
+        if (budget.max_call_depth && call_stack.size() >= budget.max_call_depth) {
+            throw std::runtime_error("Call depth limit exceeded");
+        }
+    }
+
+private:
+    static constexpr int64_t kCheckInterval = 1024;
+
+    TraceBuffer* trace_buffer = nullptr;
+
+    std::optional<std::mt19937> rng_state;
+
+    int64_t batch = INT64_MAX;
+    int64_t fuel = INT64_MAX;
+
+    // Set on contexts running split-off work: the limits apply to what the
+    // parent had used when the work was split plus what all pieces use.
+    SharedUsage* shared = nullptr;
+    uint64_t base_steps = 0;
+    size_t base_alloc_bytes = 0;
+
+    // Steps counted against the budget, up to the current batch.
+    uint64_t used_steps() const {
+        return shared ? base_steps + shared->steps.load(std::memory_order_relaxed) : steps;
+    }
+
+    void check_limits() const;
+
+    void refuel();
+
+    void next_batch();
+};
+
+inline thread_local ExecutionContext* active_context = nullptr;
+
+inline ExecutionContext& current_context() {
+    if (!active_context) throw std::runtime_error("No interpreter is running on this thread");
+    return *active_context;
+}
+
+class ContextScope {
+    ExecutionContext* previous;
+public:
+    explicit ContextScope(ExecutionContext& context) : previous(active_context) { active_context = &context; }
+    ~ContextScope() { active_context = previous; }
+
+    ContextScope(const ContextScope&) = delete;
+    ContextScope& operator=(const ContextScope&) = delete;
+};
@@ -0,0 +1,72 @@
+#include "coverage.h"
+
+void Coverage::add_lines(const std::vector<uint32_t>& lines) {
+    std::lock_guard lock(mutex);
+    for (uint32_t line : lines) counts.try_emplace(line, 0);
+}
+
+void Coverage::add_hits(const std::vector<uint64_t>& hits) {
+    std::lock_guard lock(mutex);
+    for (uint32_t line = 0; line < hits.size(); ++line) {
+        if (hits[line]) counts[line] += hits[line];
+    }
+}
+
+uint64_t Coverage::hits(uint32_t line) const {
+    std::lock_guard lock(mutex);
+    auto found = counts.find(line);
+    return found == counts.end() ? 0 : found->second;
+}
+
+size_t Coverage::lines_found() const {
+    std::lock_guard lock(mutex);
+    return counts.size();
+}
+
+size_t Coverage::lines_hit() const {
+    std::lock_guard lock(mutex);
+    size_t hit = 0;
+    for (auto& [line, count] : counts) {
+        if (count) ++hit;
+    }
+    return hit;
+}
+
+static void write_json_string(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if (c == '\n') out << "\\n";
+        else out << c;
+    }
+    out << '"';
+}
+
+void Coverage::write_lcov(std::ostream& out, const std::string& source) const {
+    size_t found = lines_found();
+    size_t hit = lines_hit();
+
+    std::lock_guard lock(mutex);
+    out << "TN:\n";
+    out << "SF:" << source << '\n';
+    for (auto& [line, count] : counts) {
+        out << "DA:" << line << ',' << count << '\n';
+    }
+    out << "LF:" << found << '\n';
+    out << "LH:" << hit << '\n';
+    out << "end_of_record\n";
+}
+
+void Coverage::write_json(std::ostream& out, const std::string& source) const {
+    std::lock_guard lock(mutex);
+    out << "{\"source\": ";
+    write_json_string(out, source);
+    out << ", \"lines\": {";
+    bool first = true;
+    for (auto& [line, count] : counts) {
+        if (!first) out << ", ";
+        first = false;
+        out << '"' << line << "\": " << count;
+    }
+    out << "}}\n";
+}
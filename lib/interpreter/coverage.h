@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Line coverage. Runs it is attached to count every statement they execute
+// against the line the statement starts on. Contexts count into a buffer of
+// their own and hand it over with add_hits() when their run or pmap chunk is
+// over, so counting costs no locking.
+class Coverage {
+    mutable std::mutex mutex;
+    // Every line a statement starts on, including the ones never executed.
+    std::map<uint32_t, uint64_t> counts;
+
+public:
+    // Lines that hold statements, so lines that never ran are reported too.
+    void add_lines(const std::vector<uint32_t>& lines);
+
+    // hits[line] executions of statements on each line.
+    void add_hits(const std::vector<uint64_t>& hits);
+
+    uint64_t hits(uint32_t line) const;
+
+    // Lines with statements and the number of them that ran at least once.
+    size_t lines_found() const;
+    size_t lines_hit() const;
+
+    // An lcov tracefile (the format genhtml reads) for a single source.
+    void write_lcov(std::ostream& out, const std::string& source) const;
+
+    // {"source": ..., "lines": {"<line>": count, ...}}
+    void write_json(std::ostream& out, const std::string& source) const;
+};
@@ -0,0 +1,94 @@
+#include "heap_profiler.h"
+#include "interpreter/memo_table.h"
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <utility>
+
+const char* heap_kind_name(HeapKind kind) {
+    switch (kind) {
+        case HeapKind::String: return "string";
+        case HeapKind::List: return "list";
+        case HeapKind::Function: return "function";
+    }
+    return "?";
+}
+
+size_t heap_bytes(const std::string& str) {
+    return sizeof(std::string) + str.capacity();
+}
+
+size_t heap_bytes(const ListValue& list) {
+    return sizeof(ListValue) + list.items.capacity() * sizeof(Value);
+}
+
+size_t heap_bytes(const Upvalues& upvalues) {
+    size_t total = sizeof(Upvalues) + upvalues.capacity() * sizeof(Upvalues::value_type);
+    // The cells themselves; what they hold is counted where it was made.
+    return total + upvalues.size() * sizeof(Value);
+}
+
+size_t heap_bytes(const MemoTable& memo) {
+    return sizeof(MemoTable) + memo.bytes();
+}
+
+size_t HeapSnapshot::total_bytes() const {
+    size_t total = 0;
+    for (size_t kind_bytes : bytes) total += kind_bytes;
+    return total;
+}
+
+void HeapProfiler::add(const void* object, Allocation allocation) {
+    std::lock_guard lock(registry->mutex);
+    ++registry->allocated[static_cast<size_t>(allocation.kind)];
+    registry->live.emplace(object, allocation);
+}
+
+size_t HeapProfiler::allocations(HeapKind kind) const {
+    std::lock_guard lock(registry->mutex);
+    return registry->allocated[static_cast<size_t>(kind)];
+}
+
+HeapSnapshot HeapProfiler::snapshot() const {
+    HeapSnapshot snapshot;
+    std::map<std::pair<uint32_t, HeapKind>, HeapSite> sites;
+
+    std::lock_guard lock(registry->mutex);
+    for (auto& [object, allocation] : registry->live) {
+        size_t bytes = allocation.measure(object);
+        size_t kind = static_cast<size_t>(allocation.kind);
+        ++snapshot.objects[kind];
+        snapshot.bytes[kind] += bytes;
+
+        HeapSite& site = sites[{allocation.line, allocation.kind}];
+        site.kind = allocation.kind;
+        site.line = allocation.line;
+        ++site.objects;
+        site.bytes += bytes;
+    }
+
+    for (auto& [key, site] : sites) snapshot.sites.push_back(site);
+    std::stable_sort(snapshot.sites.begin(), snapshot.sites.end(), [](const HeapSite& a, const HeapSite& b) {
+        return a.bytes > b.bytes;
+    });
+    return snapshot;
+}
+
+void HeapProfiler::write_report(std::ostream& out, size_t top) const {
+    HeapSnapshot heap = snapshot();
+
+    out << std::left << std::setw(10) << "kind" << std::right
+        << std::setw(10) << "objects" << std::setw(14) << "bytes" << '\n';
+    for (size_t kind = 0; kind < HeapSnapshot::kKinds; ++kind) {
+        out << std::left << std::setw(10) << heap_kind_name(static_cast<HeapKind>(kind)) << std::right
+            << std::setw(10) << heap.objects[kind] << std::setw(14) << heap.bytes[kind] << '\n';
+    }
+
+    out << '\n' << std::left << std::setw(10) << "line" << std::setw(10) << "kind" << std::right
+        << std::setw(10) << "objects" << std::setw(14) << "bytes" << '\n';
+    for (size_t i = 0; i < std::min(top, heap.sites.size()); ++i) {
+        const HeapSite& site = heap.sites[i];
+        out << std::left << std::setw(10) << site.line << std::setw(10) << heap_kind_name(site.kind) << std::right
+            << std::setw(10) << site.objects << std::setw(14) << site.bytes << '\n';
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "ast/nodes.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+enum class HeapKind { String, List, Function };
+
+const char* heap_kind_name(HeapKind kind);
+
+struct HeapSite {
+    HeapKind kind;
+    // Start line of the statement that allocated the values.
+    uint32_t line = 0;
+    size_t objects = 0;
+    size_t bytes = 0;
+};
+
+// Approximate memory held by a value: the object itself and its buffers.
+// Values it refers to are counted where they were made.
+size_t heap_bytes(const std::string& str);
+size_t heap_bytes(const ListValue& list);
+size_t heap_bytes(const Upvalues& upvalues);
+size_t heap_bytes(const MemoTable& memo);
+
+struct HeapSnapshot {
+    static constexpr size_t kKinds = 3;
+
+    std::array<size_t, kKinds> objects{};
+    std::array<size_t, kKinds> bytes{};
+    // Live values grouped by kind and line, largest first.
+    std::vector<HeapSite> sites;
+
+    size_t total_bytes() const;
+};
+
+// Heap accounting for script values. While it is attached to an interpreter,
+// strings, lists, closures' captured variables and memoized functions'
+// caches are allocated with a deleter that keeps a registry of the live ones
+// and the line they were made on. Their sizes are measured when a snapshot is
+// taken, since lists keep growing after they are made; take snapshots
+// between runs. Values may outlive the profiler: the registry is shared with
+// their deleters.
+class HeapProfiler {
+    struct Allocation {
+        HeapKind kind;
+        uint32_t line;
+        size_t (*measure)(const void*);
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::unordered_map<const void*, Allocation> live;
+        // Total allocations made per kind, freed ones included.
+        std::array<size_t, HeapSnapshot::kKinds> allocated{};
+    };
+
+    std::shared_ptr<Registry> registry = std::make_shared<Registry>();
+
+    template <typename T>
+    struct Deleter {
+        std::shared_ptr<Registry> registry;
+
+        void operator()(T* object) const {
+            {
+                std::lock_guard lock(registry->mutex);
+                registry->live.erase(object);
+            }
+            delete object;
+        }
+    };
+
+    void add(const void* object, Allocation allocation);
+
+public:
+    // Takes ownership of `object` and registers it as made on `line`.
+    template <typename T>
+    std::shared_ptr<T> track(T* object, HeapKind kind, uint32_t line) {
+        std::shared_ptr<T> owner(object, Deleter<T>{registry});
+        add(object, {kind, line, [](const void* p) { return heap_bytes(*static_cast<const T*>(p)); }});
+        return owner;
+    }
+
+    size_t allocations(HeapKind kind) const;
+
+    HeapSnapshot snapshot() const;
+
+    // Live bytes per kind, then the `top` sites holding the most.
+    void write_report(std::ostream& out, size_t top = 10) const;
+};
@@ -1,108 +1,62 @@
 #include "interpreter.h"
 #include "parser/parser.h"
 
-Interpreter::Interpreter(std::ostream& out) : output(out) {}
+Interpreter::Interpreter(std::ostream& out, std::istream& in) : output(out) {
+    context.input_stream = &in;
+}
 
 Value Interpreter::interpr(const std::string& text) {
-        Parser parser(text);
+        Parser parser(text, constants);
         auto ast = parser.parse();
-        return ast->get(symbol_table, output);
+        ContextScope scope(context);
+        context.start_run();
+        if (context.coverage) context.coverage->add_lines(parser.lines());
+        context.line = ast->line;
+        context.hit_line(ast->line);
+        Value result = ast->get(symbol_table, output);
+        if (context.control == Control::Return) result = std::move(context.return_value);
+        context.control = Control::None;
+        context.flush_coverage();
+        return result;
 }
 
-bool interpret(std::istream& input, std::ostream& output) {
-    Interpreter interpreter(output);
-    std::string line;
-
-    while (true) {
-        if (!std::getline(input, line))
-            break;
-
-        std::string trimmed = line;
-        trimmed.erase(0, trimmed.find_first_not_of(" \t"));
-
-        if (trimmed.empty() || (trimmed.size() >= 2 && trimmed[0] == '/' && trimmed[1] == '/')) continue;
-
-        bool isIf = (trimmed.rfind("if ", 0) == 0);
-        bool isFor = (trimmed.rfind("for ", 0) == 0);
-        bool isWhile = (trimmed.rfind("while ", 0) == 0);
-        bool isList = (trimmed.find("= [") != std::string::npos);
-        bool isFunctionLiteral = (trimmed.find("= function") != std::string::npos);
-
-        if (!isIf && !isFor && !isWhile && !isFunctionLiteral && !isList) {
-            try {
-                interpreter.interpr(trimmed);
-            } catch (const std::exception& e) {
-                output << "Error: " << e.what() << std::endl;
-                return false;
-            }
-            continue;
-        }
-
-        std::string block = trimmed + "\n";
-
-        int depth = 1;
-
-        bool oneLineIf = (isIf && (trimmed.find("end if") != std::string::npos));
-        bool oneLineFor = (isFor && (trimmed.find("end for") != std::string::npos));
-        bool oneLineWhile = (isWhile && (trimmed.find("end while") != std::string::npos));
-        bool oneLineFunc = (isFunctionLiteral && (trimmed.find("end function") != std::string::npos));
-        bool oneLineList = (isList && (trimmed.find("]") != std::string::npos));
+bool Interpreter::run(const Program& program) {
+    return program.run(symbol_table, context, output);
+}
 
-        if (oneLineIf || oneLineFor || oneLineWhile || oneLineFunc || oneLineList) {
-            try {
-                interpreter.interpr(block);
-            } catch (const std::exception& e) {
-                output << "Error: " << e.what() << std::endl;
-                return false;
-            }
-            continue;
-        }
+void Interpreter::set_threads(unsigned threads) {
+    context.threads = std::max(1u, threads);
+}
 
-        while (depth > 0) {
-            if (!std::getline(input, line)) {
-                output << "Error: unclosed block starting with: " << trimmed << std::endl;
-                return false;
-            }
+void Interpreter::set_memo_capacity(size_t capacity) {
+    context.memo_capacity = std::max<size_t>(1, capacity);
+}
 
-            std::string t = line;
-            t.erase(0, t.find_first_not_of(" \t"));
-            if (t.empty() || (t.size() >= 2 && t[0] == '/' && t[1] == '/')) continue;
+void Interpreter::set_budget(const Budget& budget) {
+    context.budget = budget;
+}
 
-            if (t.rfind("if ", 0) == 0) {
-                depth++;
-            }
-            if (t.rfind("for ", 0) == 0) {
-                depth++;
-            }
-            if (t.rfind("while ", 0) == 0) {
-                depth++;
-            }
-            if (t.find("= function") != std::string::npos) {
-                depth++;
-            }
-            if (t.find("= [") != std::string::npos) {
-                depth++;
-            }
+void Interpreter::set_profiler(Profiler* profiler) {
+    context.profiler = profiler;
+}
 
-            if (t.find("end if") != std::string::npos ||
-                t.find("end for") != std::string::npos ||
-                t.find("end while") != std::string::npos ||
-                t.rfind("end function", 0) == 0 ||
-                t.rfind("]", 0) == 0)
-            {
-                depth--;
-            }
+void Interpreter::set_stats(RunStats* stats) {
+    context.stats = stats;
+}
 
-            block += t + "\n";
-        }
+void Interpreter::set_coverage(Coverage* coverage) {
+    context.coverage = coverage;
+}
 
-        try {
-            interpreter.interpr(block);
-        } catch (const std::exception& e) {
-            output << "Error: " << e.what() << std::endl;
-            return false;
-        }
-    }
+void Interpreter::set_heap_profiler(HeapProfiler* heap) {
+    context.heap = heap;
+}
 
-    return true;
+void Interpreter::set_tracer(Tracer* tracer) {
+    context.tracer = tracer;
 }
+
+bool interpret(std::istream& input, std::ostream& output, std::istream& script_input) {
+    Interpreter interpreter(output, script_input);
+    return interpreter.run(*Program::compile(input));
+}
\ No newline at end of file
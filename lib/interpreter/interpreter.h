@@ -1,19 +1,60 @@
 #pragma once
-#include <iostream>
+#include <istream>
+#include <ostream>
 #include <cctype>
 #include "ast/nodes.h"
+#include "interpreter/context.h"
+#include "interpreter/program.h"
+#include "parser/constant_pool.h"
 
 
 class Interpreter;
 
 class Interpreter {
     SymbolTable symbol_table;
+    ConstantPool constants;
+    ExecutionContext context;
     std::ostream& output;
 
 public:
+    // read() and lines() consume `in`, or std::cin when it is not given.
     Interpreter(std::ostream& out);
+    Interpreter(std::ostream& out, std::istream& in);
 
     Value interpr(const std::string& text);
+
+    bool run(const Program& program);
+
+    void set_threads(unsigned threads);
+
+    // Cache size of memoize(fn) called without one.
+    void set_memo_capacity(size_t capacity);
+
+    // Limits every following run; exceeding one ends the run with an error.
+    void set_budget(const Budget& budget);
+
+    // Samples every following run into `profiler`, which must outlive
+    // them. nullptr turns profiling off.
+    void set_profiler(Profiler* profiler);
+
+    // Counts what every following run does into `stats`, which must
+    // outlive them. nullptr turns counting off.
+    void set_stats(RunStats* stats);
+
+    // Counts the statements every following run executes per line into
+    // `coverage`, which must outlive them. nullptr turns counting off.
+    void set_coverage(Coverage* coverage);
+
+    // Registers the strings, lists and function state every following run
+    // makes with `heap`, which must outlive the runs. nullptr turns heap
+    // accounting off.
+    void set_heap_profiler(HeapProfiler* heap);
+
+    // Records every following run on `tracer`'s timeline; it must outlive
+    // the runs. nullptr turns tracing off.
+    void set_tracer(Tracer* tracer);
 };
 
-bool interpret(std::istream& input, std::ostream& output);
\ No newline at end of file
+bool interpret(std::istream& input, std::ostream& output);
+
+bool interpret(std::istream& input, std::ostream& output, std::istream& script_input);
\ No newline at end of file
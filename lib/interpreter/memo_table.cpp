@@ -0,0 +1,78 @@
+#include "memo_table.h"
+#include <cstring>
+
+MemoTable::MemoTable(size_t capacity) : capacity(capacity) {}
+
+template <typename T>
+static void append_raw(std::string& key, const T& value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    key.append(bytes, sizeof(T));
+}
+
+bool MemoTable::make_key(const Value* args, size_t count, std::string& key) {
+    for (size_t i = 0; i < count; ++i) {
+        const Value& v = args[i];
+        if (std::holds_alternative<int>(v)) {
+            key.push_back('i');
+            append_raw(key, std::get<int>(v));
+        } else if (std::holds_alternative<double>(v)) {
+            key.push_back('d');
+            append_raw(key, std::get<double>(v));
+        } else if (std::holds_alternative<bool>(v)) {
+            key.push_back(std::get<bool>(v) ? 't' : 'f');
+        } else if (std::holds_alternative<Nil>(v)) {
+            key.push_back('n');
+        } else if (std::holds_alternative<std::shared_ptr<std::string>>(v)) {
+            const std::string& s = *std::get<std::shared_ptr<std::string>>(v);
+            key.push_back('s');
+            append_raw(key, s.size());
+            key.append(s);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::optional<Value> MemoTable::find(const std::string& key) {
+    std::lock_guard lock(mutex);
+    auto it = index.find(key);
+    if (it == index.end()) {
+        ++misses;
+        return std::nullopt;
+    }
+    ++hits;
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->value;
+}
+
+void MemoTable::insert(std::string key, Value value) {
+    std::lock_guard lock(mutex);
+    auto it = index.find(key);
+    if (it != index.end()) {
+        // Another thread computed the same call in the meantime.
+        it->second->value = std::move(value);
+        entries.splice(entries.begin(), entries, it->second);
+        return;
+    }
+    if (entries.size() >= capacity) {
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+    entries.push_front(Entry{std::move(key), std::move(value)});
+    index.emplace(entries.front().key, entries.begin());
+}
+
+MemoStats MemoTable::stats() const {
+    std::lock_guard lock(mutex);
+    return MemoStats{hits, misses, entries.size()};
+}
+
+size_t MemoTable::bytes() const {
+    std::lock_guard lock(mutex);
+    // A list node and an index node per entry, plus the key buffers.
+    size_t total = entries.size() * (sizeof(Entry) + sizeof(decltype(index)::value_type) + 4 * sizeof(void*));
+    for (auto& entry : entries) total += entry.key.capacity();
+    return total;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "ast/nodes.h"
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+struct MemoStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t size = 0;
+};
+
+// Results of a memoized function, keyed on its argument values. Holds at
+// most `capacity` entries and evicts the least recently used one. Shared by
+// every copy of the function value, possibly across pmap workers, so all
+// access is serialised.
+class MemoTable {
+    struct Entry {
+        std::string key;
+        Value value;
+    };
+
+    mutable std::mutex mutex;
+    size_t capacity;
+    // Most recently used first. Index keys point into the entries.
+    std::list<Entry> entries;
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+    size_t hits = 0;
+    size_t misses = 0;
+
+public:
+    static constexpr size_t kDefaultCapacity = 4096;
+
+    explicit MemoTable(size_t capacity = kDefaultCapacity);
+
+    // Encodes numbers, strings, booleans and nil. Returns false if any
+    // argument is a list or a function: those are compared by reference
+    // and may change, so such calls are not cached.
+    static bool make_key(const Value* args, size_t count, std::string& key);
+
+    std::optional<Value> find(const std::string& key);
+    void insert(std::string key, Value value);
+
+    MemoStats stats() const;
+
+    // Approximate memory held by the cached entries.
+    size_t bytes() const;
+};
@@ -0,0 +1,115 @@
+#include "profiler.h"
+#include <algorithm>
+#include <iomanip>
+
+static constexpr const char* kRootFrame = "<script>";
+
+Profiler::Profiler(uint64_t interval) : every(std::max<uint64_t>(1, interval)) {}
+
+void Profiler::sample(const std::vector<const FunctionDescriptor*>& stack, uint32_t line, std::chrono::nanoseconds elapsed) {
+    std::string key = kRootFrame;
+    for (const FunctionDescriptor* fn : stack) {
+        key += ';';
+        key += fn->name;
+    }
+
+    std::lock_guard lock(mutex);
+    ++total_samples;
+    total_time += elapsed;
+    ++stacks[key];
+
+    const std::string& top = stack.empty() ? kRootFrame : stack.back()->name;
+    Totals& exclusive = functions[top];
+    ++exclusive.exclusive_samples;
+    exclusive.exclusive += elapsed;
+
+    Totals& at_line = lines[{line, top}];
+    ++at_line.exclusive_samples;
+    at_line.exclusive += elapsed;
+
+    // A recursive function is on the stack many times but was running
+    // only once per sample.
+    std::vector<const std::string*> seen;
+    auto add_inclusive = [&](const std::string& name) {
+        for (auto* other : seen) {
+            if (*other == name) return;
+        }
+        seen.push_back(&name);
+        Totals& inclusive = functions[name];
+        ++inclusive.inclusive_samples;
+        inclusive.inclusive += elapsed;
+    };
+    static const std::string root = kRootFrame;
+    add_inclusive(root);
+    for (const FunctionDescriptor* fn : stack) add_inclusive(fn->name);
+}
+
+size_t Profiler::samples() const {
+    std::lock_guard lock(mutex);
+    return total_samples;
+}
+
+void Profiler::write_collapsed(std::ostream& out) const {
+    std::lock_guard lock(mutex);
+    for (auto& [stack, count] : stacks) {
+        out << stack << ' ' << count << '\n';
+    }
+}
+
+void Profiler::write_table(std::ostream& out) const {
+    std::lock_guard lock(mutex);
+    std::vector<std::pair<std::string, Totals>> rows(functions.begin(), functions.end());
+    std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+        if (a.second.inclusive != b.second.inclusive) return a.second.inclusive > b.second.inclusive;
+        // Equal inclusive time: a caller that was never sampled on its own
+        // comes before its callee.
+        if (a.second.exclusive != b.second.exclusive) return a.second.exclusive < b.second.exclusive;
+        return a.first < b.first;
+    });
+
+    auto ms = [](std::chrono::nanoseconds t) { return std::chrono::duration<double, std::milli>(t).count(); };
+    auto percent = [&](std::chrono::nanoseconds t) { return total_time.count() ? 100.0 * t.count() / total_time.count() : 0.0; };
+
+    size_t width = 8;
+    for (auto& row : rows) width = std::max(width, row.first.size());
+
+    out << std::left << std::setw(width) << "function"
+        << std::right << std::setw(14) << "inclusive ms" << std::setw(8) << "%"
+        << std::setw(14) << "exclusive ms" << std::setw(8) << "%"
+        << std::setw(10) << "samples" << '\n';
+    out << std::fixed << std::setprecision(2);
+    for (auto& [name, totals] : rows) {
+        out << std::left << std::setw(width) << name
+            << std::right << std::setw(14) << ms(totals.inclusive) << std::setw(8) << percent(totals.inclusive)
+            << std::setw(14) << ms(totals.exclusive) << std::setw(8) << percent(totals.exclusive)
+            << std::setw(10) << totals.inclusive_samples << '\n';
+    }
+    out << std::defaultfloat;
+}
+
+void Profiler::write_lines(std::ostream& out) const {
+    std::lock_guard lock(mutex);
+    std::vector<std::pair<std::pair<uint32_t, std::string>, Totals>> rows(lines.begin(), lines.end());
+    std::stable_sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+        return a.second.exclusive > b.second.exclusive;
+    });
+
+    auto ms = [](std::chrono::nanoseconds t) { return std::chrono::duration<double, std::milli>(t).count(); };
+    auto percent = [&](std::chrono::nanoseconds t) { return total_time.count() ? 100.0 * t.count() / total_time.count() : 0.0; };
+
+    size_t width = 8;
+    for (auto& row : rows) width = std::max(width, row.first.second.size());
+
+    out << std::right << std::setw(6) << "line" << "  "
+        << std::left << std::setw(width) << "function"
+        << std::right << std::setw(14) << "ms" << std::setw(8) << "%"
+        << std::setw(10) << "samples" << '\n';
+    out << std::fixed << std::setprecision(2);
+    for (auto& [where, totals] : rows) {
+        out << std::right << std::setw(6) << where.first << "  "
+            << std::left << std::setw(width) << where.second
+            << std::right << std::setw(14) << ms(totals.exclusive) << std::setw(8) << percent(totals.exclusive)
+            << std::setw(10) << totals.exclusive_samples << '\n';
+    }
+    out << std::defaultfloat;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "ast/nodes.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Sampling profiler. A run it is attached to reports its call stack and the
+// line of the statement being run every `interval` steps (loop iterations
+// and calls) together with the wall time spent since the previous report,
+// so the samples cover the whole run and hot spots show up in proportion to
+// their steps and their time.
+class Profiler {
+    struct Totals {
+        size_t inclusive_samples = 0;
+        size_t exclusive_samples = 0;
+        std::chrono::nanoseconds inclusive{0};
+        std::chrono::nanoseconds exclusive{0};
+    };
+
+    mutable std::mutex mutex;
+    uint64_t every;
+    size_t total_samples = 0;
+    std::chrono::nanoseconds total_time{0};
+    // Collapsed stacks ("<script>;outer;inner") and how often each was seen.
+    std::map<std::string, size_t> stacks;
+    std::unordered_map<std::string, Totals> functions;
+    // Exclusive samples and time per source line and the function it is in.
+    std::map<std::pair<uint32_t, std::string>, Totals> lines;
+
+public:
+    static constexpr uint64_t kDefaultInterval = 1000;
+
+    explicit Profiler(uint64_t interval = kDefaultInterval);
+
+    uint64_t interval() const { return every; }
+
+    // Called by the running context. Safe to call from pmap workers.
+    void sample(const std::vector<const FunctionDescriptor*>& stack, uint32_t line, std::chrono::nanoseconds elapsed);
+
+    size_t samples() const;
+
+    // One "frame;frame;frame count" line per distinct stack, the input
+    // format of flamegraph.pl and compatible tools.
+    void write_collapsed(std::ostream& out) const;
+
+    // Per-function inclusive and exclusive time, most expensive first.
+    void write_table(std::ostream& out) const;
+
+    // Per-line time, most expensive first.
+    void write_lines(std::ostream& out) const;
+};
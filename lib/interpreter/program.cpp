@@ -0,0 +1,151 @@
+#include "program.h"
+#include "parser/parser.h"
+
+void Program::add(const std::string& text, uint32_t first_line) {
+    try {
+        Parser parser(text, constants, first_line);
+        auto ast = parser.parse();
+        uint32_t line = ast->line;
+        statements.push_back({std::move(ast), {}, line});
+        statement_lines.insert(statement_lines.end(), parser.lines().begin(), parser.lines().end());
+    } catch (const LocatedError& e) {
+        statements.push_back({nullptr, e.what(), e.line});
+    } catch (const std::exception& e) {
+        statements.push_back({nullptr, e.what(), first_line});
+    }
+}
+
+std::shared_ptr<const Program> Program::compile(std::istream& input) {
+    auto program = std::make_shared<Program>();
+    std::string line;
+    uint32_t line_number = 0;
+
+    while (true) {
+        if (!std::getline(input, line))
+            break;
+        ++line_number;
+        uint32_t first_line = line_number;
+
+        std::string trimmed = line;
+        trimmed.erase(0, trimmed.find_first_not_of(" \t"));
+
+        if (trimmed.empty() || (trimmed.size() >= 2 && trimmed[0] == '/' && trimmed[1] == '/')) continue;
+
+        bool isIf = (trimmed.rfind("if ", 0) == 0);
+        bool isFor = (trimmed.rfind("for ", 0) == 0);
+        bool isWhile = (trimmed.rfind("while ", 0) == 0);
+        bool isList = (trimmed.find("= [") != std::string::npos);
+        bool isFunctionLiteral = (trimmed.find("= function") != std::string::npos);
+
+        if (!isIf && !isFor && !isWhile && !isFunctionLiteral && !isList) {
+            program->add(line, first_line);
+            continue;
+        }
+
+        // Lines are kept as they are, blank ones included, so positions
+        // the parser reports match the source.
+        std::string block = line + "\n";
+
+        int depth = 1;
+
+        bool oneLineIf = (isIf && (trimmed.find("end if") != std::string::npos));
+        bool oneLineFor = (isFor && (trimmed.find("end for") != std::string::npos));
+        bool oneLineWhile = (isWhile && (trimmed.find("end while") != std::string::npos));
+        bool oneLineFunc = (isFunctionLiteral && (trimmed.find("end function") != std::string::npos));
+        bool oneLineList = (isList && (trimmed.find("]") != std::string::npos));
+
+        if (oneLineIf || oneLineFor || oneLineWhile || oneLineFunc || oneLineList) {
+            program->add(block, first_line);
+            continue;
+        }
+
+        while (depth > 0) {
+            if (!std::getline(input, line)) {
+                program->statements.push_back({nullptr, "unclosed block starting with: " + trimmed, first_line});
+                return program;
+            }
+            ++line_number;
+
+            std::string t = line;
+            t.erase(0, t.find_first_not_of(" \t"));
+            if (t.empty() || (t.size() >= 2 && t[0] == '/' && t[1] == '/')) {
+                block += "\n";
+                continue;
+            }
+
+            if (t.rfind("if ", 0) == 0) {
+                depth++;
+            }
+            if (t.rfind("for ", 0) == 0) {
+                depth++;
+            }
+            if (t.rfind("while ", 0) == 0) {
+                depth++;
+            }
+            if (t.find("= function") != std::string::npos) {
+                depth++;
+            }
+            if (t.find("= [") != std::string::npos) {
+                depth++;
+            }
+
+            if (t.find("end if") != std::string::npos ||
+                t.find("end for") != std::string::npos ||
+                t.find("end while") != std::string::npos ||
+                t.rfind("end function", 0) == 0 ||
+                t.rfind("]", 0) == 0)
+            {
+                depth--;
+            }
+
+            block += line + "\n";
+        }
+
+        program->add(block, first_line);
+    }
+
+    return program;
+}
+
+
+static void report(std::ostream& output, const char* message, uint32_t line) {
+    output << "Error: " << message << " (line " << line << ")" << std::endl;
+}
+
+bool Program::run(SymbolTable& symbols, ExecutionContext& context, std::ostream& output) const {
+    ContextScope scope(context);
+    context.start_run();
+    if (context.coverage) context.coverage->add_lines(statement_lines);
+
+    bool ok = run_statements(symbols, context, output);
+    context.flush_coverage();
+    return ok;
+}
+
+bool Program::run_statements(SymbolTable& symbols, ExecutionContext& context, std::ostream& output) const {
+    for (auto& statement : statements) {
+        if (!statement.ast) {
+            report(output, statement.error.c_str(), statement.line);
+            return false;
+        }
+        context.line = statement.line;
+        context.hit_line(statement.line);
+        try {
+            statement.ast->get(symbols, output);
+        } catch (const LocatedError& e) {
+            report(output, e.what(), e.line);
+            return false;
+        } catch (const std::exception& e) {
+            report(output, e.what(), statement.line);
+            return false;
+        }
+
+        // `return` outside of any function ends the script.
+        if (context.control != Control::None) {
+            context.control = Control::None;
+            break;
+        }
+    }
+
+    return true;
+}
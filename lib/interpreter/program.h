@@ -0,0 +1,34 @@
+#pragma once
+#include "ast/nodes.h"
+#include "interpreter/context.h"
+#include "parser/constant_pool.h"
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class Program {
+    struct Statement {
+        std::unique_ptr<ASTNode> ast;
+        std::string error;
+        uint32_t line = 0;
+    };
+
+    ConstantPool constants;
+    std::vector<Statement> statements;
+    // Start lines of all statements, nested ones included, in order.
+    std::vector<uint32_t> statement_lines;
+
+    void add(const std::string& text, uint32_t first_line);
+
+    bool run_statements(SymbolTable& symbols, ExecutionContext& context, std::ostream& output) const;
+
+public:
+    static std::shared_ptr<const Program> compile(std::istream& source);
+
+    bool run(SymbolTable& symbols, ExecutionContext& context, std::ostream& output) const;
+
+    const std::vector<uint32_t>& lines() const { return statement_lines; }
+};
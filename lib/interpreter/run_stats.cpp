@@ -0,0 +1,23 @@
+#include "run_stats.h"
+
+const char* RunStats::name(Counter counter) {
+    switch (counter) {
+        case Lookups: return "lookups";
+        case StringAllocations: return "string_allocations";
+        case ListAllocations: return "list_allocations";
+        case Calls: return "calls";
+        case Exceptions: return "exceptions";
+        default: return "?";
+    }
+}
+
+void RunStats::reset() {
+    for (auto& counter : counters) counter.store(0, std::memory_order_relaxed);
+}
+
+void RunStats::write(std::ostream& out) const {
+    for (size_t i = 0; i < kCounters; ++i) {
+        auto counter = static_cast<Counter>(i);
+        out << name(counter) << ' ' << get(counter) << '\n';
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Counters of what the runs it is attached to did, for tuning scripts.
+// Nothing is counted while no collector is attached. pmap workers add to
+// the same collector as the run that started them.
+class RunStats {
+public:
+    enum Counter {
+        Lookups,            // variable reads
+        StringAllocations,  // strings built by the script
+        ListAllocations,    // lists built by the script
+        Calls,              // function calls, tail calls included
+        Exceptions,         // break and continue, which unwind by throwing
+        kCounters
+    };
+
+    static const char* name(Counter counter);
+
+    void add(Counter counter, uint64_t n = 1) {
+        counters[counter].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t get(Counter counter) const {
+        return counters[counter].load(std::memory_order_relaxed);
+    }
+
+    void reset();
+
+    // One "name value" line per counter.
+    void write(std::ostream& out) const;
+
+private:
+    std::array<std::atomic<uint64_t>, kCounters> counters{};
+};
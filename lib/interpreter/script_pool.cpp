@@ -0,0 +1,71 @@
+#include "script_pool.h"
+#include <latch>
+#include <sstream>
+
+ScriptPool::ScriptPool(unsigned workers) : threads(workers) {
+    for (size_t i = 0; i < threads.size(); ++i) {
+        contexts.push_back(std::make_unique<ExecutionContext>());
+    }
+}
+
+std::shared_ptr<const Program> ScriptPool::compile(const std::string& source, std::chrono::nanoseconds& elapsed) {
+    {
+        std::lock_guard lock(cache_mutex);
+        auto it = cache.find(source);
+        if (it != cache.end()) return it->second;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::istringstream in(source);
+    auto program = Program::compile(in);
+    elapsed = std::chrono::steady_clock::now() - start;
+
+    // Two workers may race to compile the same source; the first one wins
+    // and both run the same Program from then on.
+    std::lock_guard lock(cache_mutex);
+    return cache.emplace(source, std::move(program)).first->second;
+}
+
+void ScriptPool::execute(const ScriptJob& job, JobResult& result) {
+    auto program = compile(job.source, result.compile_time);
+
+    ExecutionContext& context = *contexts[threads.worker_index()];
+    context.call_stack.clear();
+
+    std::istringstream in(job.input);
+    context.input = std::make_unique<InputReader>(in);
+
+    std::ostringstream out;
+    SymbolTable symbols;
+
+    auto start = std::chrono::steady_clock::now();
+    result.ok = program->run(symbols, context, out);
+    result.run_time = std::chrono::steady_clock::now() - start;
+    result.output = std::move(out).str();
+
+    context.input.reset();
+}
+
+void ScriptPool::set_budget(const Budget& budget) {
+    for (auto& context : contexts) context->budget = budget;
+}
+
+std::vector<JobResult> ScriptPool::run(const std::vector<ScriptJob>& jobs) {
+    std::vector<JobResult> results(jobs.size());
+    std::latch done(static_cast<std::ptrdiff_t>(jobs.size()));
+
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        threads.submit([this, &jobs, &results, &done, i] {
+            try {
+                execute(jobs[i], results[i]);
+            } catch (const std::exception& e) {
+                results[i].output += std::string("Error: ") + e.what() + "\n";
+                results[i].ok = false;
+            }
+            done.count_down();
+        });
+    }
+
+    done.wait();
+    return results;
+}
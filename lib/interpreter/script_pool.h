@@ -0,0 +1,45 @@
+#pragma once
+#include "interpreter/program.h"
+#include "interpreter/thread_pool.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ScriptJob {
+    std::string source;
+    std::string input;
+};
+
+struct JobResult {
+    std::string output;
+    bool ok = false;
+    std::chrono::nanoseconds compile_time{0};
+    std::chrono::nanoseconds run_time{0};
+};
+
+// Runs batches of scripts on a fixed set of workers. Each distinct source
+// is compiled once and the resulting Program is shared by every job that
+// uses it; every job still gets its own globals, output and input.
+class ScriptPool {
+    ThreadPool threads;
+
+    std::mutex cache_mutex;
+    std::unordered_map<std::string, std::shared_ptr<const Program>> cache;
+
+    std::vector<std::unique_ptr<ExecutionContext>> contexts;
+
+    std::shared_ptr<const Program> compile(const std::string& source, std::chrono::nanoseconds& elapsed);
+
+    void execute(const ScriptJob& job, JobResult& result);
+
+public:
+    explicit ScriptPool(unsigned workers = std::thread::hardware_concurrency());
+
+    // Applies to each job separately.
+    void set_budget(const Budget& budget);
+
+    std::vector<JobResult> run(const std::vector<ScriptJob>& jobs);
+};
@@ -0,0 +1,136 @@
+#include "stack_segments.h"
+#include "interpreter/context.h"
+#include <exception>
+#include <pthread.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <vector>
+
+namespace stack_segments {
+
+namespace {
+
+constexpr size_t kFallbackStack = 512 * 1024;
+constexpr size_t kSpareSegments = 2;
+
+struct Segment {
+    char* base;
+    size_t size;
+};
+
+// Everything run_on_new_segment() needs back after swapcontext() lives here:
+// the object's address is taken, so none of it is kept in registers that
+// the switch could clobber.
+struct Trampoline {
+    const std::function<void()>* fn;
+    std::exception_ptr error;
+    ucontext_t caller;
+    Segment segment;
+    char* previous_limit;
+};
+
+thread_local size_t bytes_in_use = 0;
+thread_local std::vector<Segment> spare;
+thread_local Trampoline* starting = nullptr;
+
+struct SpareSegments {
+    ~SpareSegments() {
+        for (auto& segment : spare) munmap(segment.base, segment.size);
+    }
+};
+thread_local SpareSegments spare_cleanup;
+
+size_t page_size() {
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+Segment acquire() {
+    if (!spare.empty()) {
+        Segment segment = spare.back();
+        spare.pop_back();
+        return segment;
+    }
+
+    void* base = mmap(nullptr, kSegmentSize, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if (base == MAP_FAILED) throw std::runtime_error("Stack overflow");
+
+    // The lowest page stays inaccessible so that running off the end of a
+    // segment faults instead of corrupting whatever is mapped below it.
+    mprotect(base, page_size(), PROT_NONE);
+    return {static_cast<char*>(base), kSegmentSize};
+}
+
+void release(Segment segment) {
+    if (spare.size() < kSpareSegments) {
+        (void)spare_cleanup;
+        spare.push_back(segment);
+    } else {
+        munmap(segment.base, segment.size);
+    }
+}
+
+void entry() {
+    Trampoline* trampoline = starting;
+    try {
+        (*trampoline->fn)();
+    } catch (...) {
+        trampoline->error = std::current_exception();
+    }
+}
+
+size_t max_bytes() {
+    return active_context ? active_context->budget.max_stack_bytes : Budget{}.max_stack_bytes;
+}
+
+} // namespace
+
+char* native_limit() {
+    char* here = static_cast<char*>(__builtin_frame_address(0));
+
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+        void* addr = nullptr;
+        size_t size = 0;
+        bool ok = pthread_attr_getstack(&attr, &addr, &size) == 0;
+        pthread_attr_destroy(&attr);
+
+        char* low = static_cast<char*>(addr);
+        if (ok && here > low && static_cast<size_t>(here - low) <= size) {
+            return low + page_size();
+        }
+    }
+    return here - kFallbackStack;
+}
+
+void run_on_new_segment(const std::function<void()>& fn) {
+    size_t cap = max_bytes();
+    if (cap && bytes_in_use + kSegmentSize > cap) {
+        throw std::runtime_error("Stack overflow");
+    }
+
+    Trampoline trampoline{&fn, nullptr, {}, acquire(), limit};
+    bytes_in_use += trampoline.segment.size;
+    limit = trampoline.segment.base + page_size();
+
+    ucontext_t callee;
+    getcontext(&callee);
+    callee.uc_stack.ss_sp = trampoline.segment.base;
+    callee.uc_stack.ss_size = trampoline.segment.size;
+    callee.uc_link = &trampoline.caller;
+    makecontext(&callee, entry, 0);
+
+    starting = &trampoline;
+    swapcontext(&trampoline.caller, &callee);
+
+    limit = trampoline.previous_limit;
+    bytes_in_use -= trampoline.segment.size;
+    release(trampoline.segment);
+
+    if (trampoline.error) std::rethrow_exception(trampoline.error);
+}
+
+} // namespace stack_segments
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <optional>
+
+// Every script call goes through several interpreter frames on the native
+// stack, so the native stack, not the heap, used to bound recursion depth.
+// maybe_grow() runs its argument on a fresh heap-allocated stack segment
+// whenever the current one is close to full; segments are chained for as
+// long as the recursion keeps going and released as it unwinds.
+namespace stack_segments {
+
+constexpr size_t kRedZone = 256 * 1024;
+constexpr size_t kSegmentSize = 4 * 1024 * 1024;
+
+inline thread_local char* limit = nullptr;
+
+char* native_limit();
+
+// Runs fn to completion on a new segment. Exceptions thrown by fn are
+// rethrown on the calling stack. Throws "Stack overflow" once the segments
+// in use would exceed the running context's max_stack_bytes.
+void run_on_new_segment(const std::function<void()>& fn);
+
+inline size_t remaining() {
+    if (!limit) limit = native_limit();
+    char* here = static_cast<char*>(__builtin_frame_address(0));
+    return here > limit ? static_cast<size_t>(here - limit) : 0;
+}
+
+} // namespace stack_segments
+
+template <typename F>
+auto maybe_grow(F&& fn) -> decltype(fn()) {
+    if (stack_segments::remaining() > stack_segments::kRedZone) return fn();
+
+    std::optional<decltype(fn())> result;
+    stack_segments::run_on_new_segment([&] { result.emplace(fn()); });
+    return std::move(*result);
+}
@@ -0,0 +1,12 @@
+#include "interpreter.h"
+#include <iostream>
+
+// The overloads without a script input read from std::cin. They live apart
+// from the rest of the interpreter so that only programs calling them link
+// in the standard stream objects and their static initialisation.
+
+Interpreter::Interpreter(std::ostream& out) : Interpreter(out, std::cin) {}
+
+bool interpret(std::istream& input, std::ostream& output) {
+    return interpret(input, output, std::cin);
+}
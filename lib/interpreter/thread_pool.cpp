@@ -0,0 +1,100 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+namespace {
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_index = ThreadPool::npos;
+}
+
+ThreadPool::ThreadPool(size_t workers) {
+    if (workers == 0) workers = 1;
+    for (size_t i = 0; i < workers; ++i) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 0; i < workers; ++i) {
+        threads.emplace_back([this, i] { loop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(wake_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : threads) t.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    size_t index = worker_index();
+    if (index == npos) index = next_queue++ % queues.size();
+
+    {
+        std::lock_guard lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard lock(wake_mutex);
+        ++pending;
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::pop(size_t index, std::function<void()>& task) {
+    Queue& queue = *queues[index];
+    std::lock_guard lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(size_t thief, std::function<void()>& task) {
+    for (size_t k = 1; k <= queues.size(); ++k) {
+        Queue& queue = *queues[(thief + k) % queues.size()];
+        std::lock_guard lock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+bool ThreadPool::run_pending() {
+    size_t index = worker_index();
+    std::function<void()> task;
+    bool found = index != npos ? (pop(index, task) || steal(index, task)) : steal(0, task);
+    if (!found) return false;
+
+    --pending;
+    task();
+    return true;
+}
+
+size_t ThreadPool::worker_index() const {
+    return current_pool == this ? current_index : npos;
+}
+
+void ThreadPool::loop(size_t index) {
+    current_pool = this;
+    current_index = index;
+
+    while (true) {
+        std::function<void()> task;
+        if (pop(index, task) || steal(index, task)) {
+            --pending;
+            task();
+            continue;
+        }
+
+        std::unique_lock lock(wake_mutex);
+        wake.wait(lock, [this] { return stopping || pending > 0; });
+        if (stopping && pending == 0) return;
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool(std::max(2u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    std::atomic<size_t> pending{0};
+    std::atomic<size_t> next_queue{0};
+    bool stopping = false;
+
+    bool pop(size_t index, std::function<void()>& task);
+
+    bool steal(size_t thief, std::function<void()>& task);
+
+    void loop(size_t index);
+
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    explicit ThreadPool(size_t workers = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return threads.size(); }
+
+    // Tasks submitted from a worker go to that worker's own queue; idle
+    // workers steal from the opposite end of the other queues.
+    void submit(std::function<void()> task);
+
+    // Runs one queued task on the calling thread, if there is one.
+    bool run_pending();
+
+    // Index of the calling worker in this pool, or npos.
+    size_t worker_index() const;
+
+    // Process-wide pool for data-parallel builtins. Callers are expected to
+    // help with their own work, so it has one thread fewer than the machine.
+    static ThreadPool& shared();
+};
@@ -0,0 +1,93 @@
+#include "tracer.h"
+#include <algorithm>
+#include <iomanip>
+
+TraceBuffer::TraceBuffer(std::thread::id thread, size_t capacity)
+    : events(std::max<size_t>(1, capacity)), thread(thread) {}
+
+std::vector<TraceEvent> TraceBuffer::read() const {
+    uint64_t n = written.load(std::memory_order_acquire);
+    uint64_t held = std::min<uint64_t>(n, events.size());
+    std::vector<TraceEvent> result;
+    result.reserve(held);
+    for (uint64_t i = n - held; i < n; ++i) {
+        result.push_back(events[i % events.size()]);
+    }
+    return result;
+}
+
+uint64_t TraceBuffer::dropped() const {
+    uint64_t n = written.load(std::memory_order_acquire);
+    return n > events.size() ? n - events.size() : 0;
+}
+
+Tracer::Tracer(size_t capacity) : capacity(capacity) {}
+
+TraceBuffer& Tracer::buffer() {
+    std::lock_guard lock(mutex);
+    auto id = std::this_thread::get_id();
+    for (auto& buffer : buffers) {
+        if (buffer->thread == id) return *buffer;
+    }
+    buffers.push_back(std::make_unique<TraceBuffer>(id, capacity));
+    return *buffers.back();
+}
+
+size_t Tracer::events() const {
+    std::lock_guard lock(mutex);
+    size_t total = 0;
+    for (auto& buffer : buffers) total += buffer->read().size();
+    return total;
+}
+
+uint64_t Tracer::dropped() const {
+    std::lock_guard lock(mutex);
+    uint64_t total = 0;
+    for (auto& buffer : buffers) total += buffer->dropped();
+    return total;
+}
+
+static void write_micros(std::ostream& out, uint64_t ns) {
+    out << ns / 1000 << '.' << std::setw(3) << std::setfill('0') << ns % 1000 << std::setfill(' ');
+}
+
+static void write_json_string(std::ostream& out, const char* text) {
+    out << '"';
+    for (; *text; ++text) {
+        if (*text == '"' || *text == '\\') out << '\\';
+        out << *text;
+    }
+    out << '"';
+}
+
+void Tracer::write_json(std::ostream& out) const {
+    std::lock_guard lock(mutex);
+    out << "{\"traceEvents\": [";
+    bool first = true;
+    auto separate = [&] {
+        if (!first) out << ",";
+        out << "\n  ";
+        first = false;
+    };
+
+    for (size_t tid = 0; tid < buffers.size(); ++tid) {
+        separate();
+        out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << tid
+            << ", \"args\": {\"name\": \"";
+        if (tid == 0) out << "script";
+        else out << "worker " << tid;
+        out << "\"}}";
+
+        for (const TraceEvent& event : buffers[tid]->read()) {
+            separate();
+            out << "{\"name\": ";
+            write_json_string(out, event.name.get());
+            out << ", \"cat\": \"" << event.category << "\", \"ph\": \"X\", \"ts\": ";
+            write_micros(out, event.start);
+            out << ", \"dur\": ";
+            write_micros(out, event.duration);
+            out << ", \"pid\": 1, \"tid\": " << tid << "}";
+        }
+    }
+    out << "\n], \"displayTimeUnit\": \"ns\"}\n";
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+struct TraceEvent {
+    // Function names keep their descriptor alive; builtin names are
+    // literals with no owner.
+    std::shared_ptr<const char> name;
+    const char* category = "";
+    // Nanoseconds since the tracer was made.
+    uint64_t start = 0;
+    uint64_t duration = 0;
+};
+
+// The events of one thread. Only that thread writes to it, so appending
+// takes no lock; once full, the oldest events are overwritten.
+class TraceBuffer {
+    std::vector<TraceEvent> events;
+    std::atomic<uint64_t> written{0};
+
+public:
+    const std::thread::id thread;
+
+    TraceBuffer(std::thread::id thread, size_t capacity);
+
+    void push(TraceEvent event) {
+        uint64_t n = written.load(std::memory_order_relaxed);
+        events[n % events.size()] = std::move(event);
+        written.store(n + 1, std::memory_order_release);
+    }
+
+    // The events still held, oldest first.
+    std::vector<TraceEvent> read() const;
+
+    uint64_t dropped() const;
+};
+
+// Timeline of function bodies, builtins and printing, written out as
+// Chrome trace_event JSON for chrome://tracing and Perfetto. Every thread a
+// traced run uses gets a buffer of its own. Dump after the runs are over.
+class Tracer {
+    mutable std::mutex mutex;
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    size_t capacity;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+
+public:
+    static constexpr size_t kDefaultCapacity = size_t(1) << 16;
+
+    // `capacity` events are kept per thread.
+    explicit Tracer(size_t capacity = kDefaultCapacity);
+
+    uint64_t now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    // The calling thread's buffer, made on first use.
+    TraceBuffer& buffer();
+
+    size_t events() const;
+
+    // Events overwritten because a buffer was full.
+    uint64_t dropped() const;
+
+    // {"traceEvents": [...]} with one complete ("X") event per record and
+    // timestamps in microseconds.
+    void write_json(std::ostream& out) const;
+};
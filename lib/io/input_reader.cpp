@@ -0,0 +1,102 @@
+#include "input_reader.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+InputReader::InputReader(int descriptor) : fd(descriptor) {
+    if (!try_map()) {
+        capacity = kBufferSize;
+        buffer = std::make_unique<char[]>(capacity);
+        data = buffer.get();
+    }
+}
+
+InputReader::InputReader(std::istream& in) : stream(&in) {
+    capacity = kBufferSize;
+    buffer = std::make_unique<char[]>(capacity);
+    data = buffer.get();
+}
+
+InputReader::InputReader(const std::string& path) : file(std::make_unique<MappedFile>(path)) {
+    std::string_view contents = file->view();
+    data = contents.data();
+    end = contents.size();
+    eof = true;
+}
+
+InputReader::~InputReader() = default;
+
+bool InputReader::try_map() {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) return false;
+
+    off_t offset = lseek(fd, 0, SEEK_CUR);
+    if (offset < 0 || offset >= st.st_size) return false;
+
+    try {
+        file = std::make_unique<MappedFile>(fd, st.st_size);
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+
+    data = file->view().data();
+    begin = offset;
+    end = file->view().size();
+    eof = true;
+    return true;
+}
+
+void InputReader::refill() {
+    if (begin > 0) {
+        std::memmove(buffer.get(), buffer.get() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+    }
+    if (end == capacity) {
+        auto bigger = std::make_unique<char[]>(capacity * 2);
+        std::memcpy(bigger.get(), buffer.get(), end);
+        buffer = std::move(bigger);
+        capacity *= 2;
+    }
+    data = buffer.get();
+
+    size_t got = 0;
+    if (stream) {
+        got = stream->rdbuf()->sgetn(buffer.get() + end, capacity - end);
+    } else {
+        ssize_t n;
+        do {
+            n = ::read(fd, buffer.get() + end, capacity - end);
+        } while (n < 0 && errno == EINTR);
+        if (n < 0) throw std::runtime_error("read() failed on input stream");
+        got = static_cast<size_t>(n);
+    }
+
+    if (got == 0) eof = true;
+    end += got;
+}
+
+bool InputReader::next_line(std::string_view& line) {
+    size_t scanned = begin;
+    while (true) {
+        auto nl = scanned < end
+            ? static_cast<const char*>(std::memchr(data + scanned, '\n', end - scanned))
+            : nullptr;
+        if (nl) {
+            size_t pos = nl - data;
+            line = std::string_view(data + begin, pos - begin);
+            begin = pos + 1;
+            return true;
+        }
+        if (eof) {
+            if (begin == end) return false;
+            line = std::string_view(data + begin, end - begin);
+            begin = end;
+            return true;
+        }
+        scanned = end - begin;
+        refill();
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "mapped_file.h"
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <string_view>
+
+class InputReader {
+    static constexpr size_t kBufferSize = 1 << 20;
+
+    int fd = -1;
+    std::istream* stream = nullptr;
+
+    std::unique_ptr<char[]> buffer;
+    size_t capacity = 0;
+
+    std::unique_ptr<MappedFile> file;
+
+    const char* data = nullptr;
+    size_t begin = 0;
+    size_t end = 0;
+    bool eof = false;
+
+    bool try_map();
+
+    void refill();
+
+public:
+    explicit InputReader(int descriptor);
+    explicit InputReader(std::istream& in);
+    explicit InputReader(const std::string& path);
+    ~InputReader();
+
+    InputReader(const InputReader&) = delete;
+    InputReader& operator=(const InputReader&) = delete;
+
+    // The view stays valid until the next call to next_line().
+    bool next_line(std::string_view& line);
+};
@@ -0,0 +1,48 @@
+#include "mapped_file.h"
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw std::runtime_error("Cannot open file: " + path);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        throw std::runtime_error("Not a regular file: " + path);
+    }
+
+    try {
+        map(fd, st.st_size);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+}
+
+MappedFile::MappedFile(int fd, size_t size) {
+    map(fd, size);
+}
+
+MappedFile::~MappedFile() {
+    if (mapping) munmap(mapping, length);
+}
+
+void MappedFile::map(int fd, size_t size) {
+    if (size == 0) return;
+
+    void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) throw std::runtime_error("mmap() failed");
+    madvise(p, size, MADV_SEQUENTIAL);
+
+    mapping = p;
+    length = size;
+}
+
+std::string_view MappedFile::view() const {
+    return std::string_view(static_cast<const char*>(mapping), length);
+}
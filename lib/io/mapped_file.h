@@ -0,0 +1,21 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+class MappedFile {
+    void* mapping = nullptr;
+    size_t length = 0;
+
+    void map(int fd, size_t size);
+
+public:
+    explicit MappedFile(const std::string& path);
+    MappedFile(int fd, size_t size);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view view() const;
+};
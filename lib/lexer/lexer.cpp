@@ -1,8 +1,100 @@
 #include "lexer.h"
 #include "tokens/tokens.h"
+#include <algorithm>
+#include <array>
+#include <optional>
 #include <stdexcept>
+#include <string_view>
+#include <utility>
+
+// Keywords and builtin names, sorted so lookups can binary search. Built at
+// compile time, so nothing runs before main() to set it up.
+static constexpr std::array<std::pair<std::string_view, TokenType>, 39> kKeywords{{
+    {"MAX", TokenType::MAX},
+    {"MIN", TokenType::MIN},
+    {"abs", TokenType::ABS},
+    {"and", TokenType::AND},
+    {"break", TokenType::BREAK},
+    {"ceil", TokenType::CEIL},
+    {"continue", TokenType::CONTINUE},
+    {"else", TokenType::ELSE},
+    {"floor", TokenType::FLOOR},
+    {"for", TokenType::FOR},
+    {"function", TokenType::FUNCTION},
+    {"if", TokenType::IF},
+    {"in", TokenType::IN},
+    {"insert", TokenType::INSERT},
+    {"join", TokenType::JOIN},
+    {"len", TokenType::LEN},
+    {"lower", TokenType::LOWER},
+    {"nil", TokenType::NIL},
+    {"not", TokenType::NOT},
+    {"or", TokenType::OR},
+    {"parse_num", TokenType::PARSE_NUM},
+    {"pop", TokenType::POP},
+    {"print", TokenType::PRINT},
+    {"println", TokenType::PRINTLN},
+    {"push", TokenType::PUSH},
+    {"read", TokenType::READ},
+    {"remove", TokenType::REMOVE},
+    {"replace", TokenType::REPLACE},
+    {"return", TokenType::RETURN},
+    {"rnd", TokenType::RND},
+    {"round", TokenType::ROUND},
+    {"sort", TokenType::SORT},
+    {"split", TokenType::SPLIT},
+    {"sqrt", TokenType::SQRT},
+    {"stacktrace", TokenType::STACKTRACE},
+    {"then", TokenType::THEN},
+    {"to_string", TokenType::TO_STRING},
+    {"upper", TokenType::UPPER},
+    {"while", TokenType::WHILE},
+}};
+
+// Builtins added after the names above were reserved. They only count as
+// builtins right before "(", so scripts can still use them as variables.
+static constexpr std::array<std::pair<std::string_view, TokenType>, 15> kCallOnlyBuiltins{{
+    {"count", TokenType::COUNT},
+    {"file_bytes", TokenType::FILE_BYTES},
+    {"file_lines", TokenType::FILE_LINES},
+    {"filter", TokenType::FILTER},
+    {"is_alpha", TokenType::IS_ALPHA},
+    {"is_digit", TokenType::IS_DIGIT},
+    {"lines", TokenType::LINES},
+    {"map", TokenType::MAP},
+    {"memo_stats", TokenType::MEMO_STATS},
+    {"memoize", TokenType::MEMOIZE},
+    {"pmap", TokenType::PMAP},
+    {"read_file", TokenType::READ_FILE},
+    {"reduce", TokenType::REDUCE},
+    {"run_stats", TokenType::STATS},
+    {"trim", TokenType::TRIM},
+}};
+
+template <size_t N>
+static constexpr bool is_sorted_table(const std::array<std::pair<std::string_view, TokenType>, N>& table) {
+    return std::is_sorted(table.begin(), table.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+}
+
+static_assert(is_sorted_table(kKeywords));
+static_assert(is_sorted_table(kCallOnlyBuiltins));
+
+template <size_t N>
+static std::optional<TokenType> find_word(const std::array<std::pair<std::string_view, TokenType>, N>& table,
+                                          std::string_view word) {
+    auto it = std::lower_bound(table.begin(), table.end(), word,
+                               [](const auto& entry, std::string_view w) { return entry.first < w; });
+    if (it == table.end() || it->first != word) return std::nullopt;
+    return it->second;
+}
 
 void Lexer::step() {
+    if (current_char == '\n') {
+        ++line;
+        column = 1;
+    } else {
+        ++column;
+    }
     pos++;
     current_char = (pos < text.size()) ? text[pos] : '\0';
 }
@@ -11,6 +103,12 @@ char Lexer::peek(size_t ahead) const {
     return (pos + ahead < text.size()) ? text[pos + ahead] : '\0';
 }
 
+bool Lexer::next_is_call() const {
+    size_t ahead = pos;
+    while (ahead < text.size() && isspace(text[ahead])) ++ahead;
+    return ahead < text.size() && text[ahead] == '(';
+}
+
 void Lexer::skip_whitespace() {
     while (current_char != '\0' && isspace(current_char)) step();
 }
@@ -47,9 +145,28 @@ std::string Lexer::number() {
 }
 
 
-Lexer::Lexer(const std::string& t) : text(t), current_char(t.empty() ? '\0' : t[0]) {}
+Lexer::Lexer(const std::string& t, uint32_t first_line) : text(t), current_char(t.empty() ? '\0' : t[0]), line(first_line) {}
 
 Token Lexer::get_next_token() {
+    while (true) {
+        if (current_char == '/' && peek(1) == '/') {
+            while (current_char != '\n' && current_char != '\0') step();
+        } else if (current_char != '\0' && isspace(current_char)) {
+            skip_whitespace();
+        } else {
+            break;
+        }
+    }
+
+    uint32_t start_line = line;
+    uint32_t start_column = column;
+    Token token = scan_token();
+    token.line = start_line;
+    token.column = start_column;
+    return token;
+}
+
+Token Lexer::scan_token() {
     while (current_char != '\0') {
         if (current_char == '/' && peek(1) == '/') {
             while (current_char != '\n' && current_char != '\0') {
@@ -129,48 +246,11 @@ Token Lexer::get_next_token() {
                 return Token(TokenType::END);
             }
             
-            if (word == "print") return Token(TokenType::PRINT);
-            if (word == "println") return Token(TokenType::PRINTLN);
-            if (word == "read") return Token(TokenType::READ);
-            if (word == "stacktrace") return Token(TokenType::STACKTRACE);
-            if (word == "if") return Token(TokenType::IF);
-            if (word == "then") return Token(TokenType::THEN);
-            if (word == "else") return Token(TokenType::ELSE);
             if (word == "true") return Token(TokenType::BOOL, "true");
             if (word == "false") return Token(TokenType::BOOL, "false");
-            if (word == "for") return Token(TokenType::FOR);
-            if (word == "in") return Token(TokenType::IN);
-            if (word == "while") return Token(TokenType::WHILE);
-            if (word == "and") return Token(TokenType::AND);
-            if (word == "or") return Token(TokenType::OR);
-            if (word == "not") return Token(TokenType::NOT);
-            if (word == "function") return Token(TokenType::FUNCTION);
-            if (word == "return") return Token(TokenType::RETURN);
-            if (word == "push") return Token(TokenType::PUSH);
-            if (word == "pop") return Token(TokenType::POP);
-            if (word == "insert") return Token(TokenType::INSERT);
-            if (word == "remove") return Token(TokenType::REMOVE);
-            if (word == "sort") return Token(TokenType::SORT);
-            if (word == "len") return Token(TokenType::LEN);
-            if (word == "MAX") return Token(TokenType::MAX);
-            if (word == "MIN") return Token(TokenType::MIN);
-            if (word == "nil") return Token(TokenType::NIL);
-            if (word == "ceil") return Token(TokenType::CEIL);
-            if (word == "abs") return Token(TokenType::ABS);
-            if (word == "floor") return Token(TokenType::FLOOR);
-            if (word == "round") return Token(TokenType::ROUND);
-            if (word == "sqrt") return Token(TokenType::SQRT);
-            if (word == "rnd") return Token(TokenType::RND);
-            if (word == "parse_num") return Token(TokenType::PARSE_NUM);
-            if (word == "to_string") return Token(TokenType::TO_STRING);
-            if (word == "lower") return Token(TokenType::LOWER);
-            if (word == "upper") return Token(TokenType::UPPER);
-            if (word == "split") return Token(TokenType::SPLIT);
-            if (word == "join") return Token(TokenType::JOIN);
-            if (word == "replace") return Token(TokenType::REPLACE);
-            if (word == "break")    return Token(TokenType::BREAK);
-            if (word == "continue") return Token(TokenType::CONTINUE);
-            
+            if (auto keyword = find_word(kKeywords, word)) return Token(*keyword);
+            if (auto builtin = find_word(kCallOnlyBuiltins, word); builtin && next_is_call()) return Token(*builtin);
+
             return Token(TokenType::VAR, word);
         }
 
@@ -6,17 +6,25 @@ class Lexer {
     std::string text;
     size_t pos = 0;
     char current_char;
+    uint32_t line;
+    uint32_t column = 1;
 
     void step();
 
     char peek(size_t ahead = 1) const;
 
+    // Whether the next character after any whitespace is "(".
+    bool next_is_call() const;
+
     void skip_whitespace();
 
     std::string number();
 
+    Token scan_token();
+
 public:
-    Lexer(const std::string& t);
+    // `first_line` is the line of the whole source the text starts on.
+    Lexer(const std::string& t, uint32_t first_line = 1);
 
     Token get_next_token();
 };
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+class ConstantPool {
+    std::unordered_map<std::string_view, std::shared_ptr<std::string>> strings;
+
+public:
+    std::shared_ptr<std::string> intern(const std::string& value);
+};
+
+inline std::shared_ptr<std::string> ConstantPool::intern(const std::string& value) {
+    auto it = strings.find(value);
+    if (it != strings.end()) return it->second;
+
+    auto constant = std::make_shared<std::string>(value);
+    strings.emplace(*constant, constant);
+    return constant;
+}
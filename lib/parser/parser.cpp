@@ -1,6 +1,7 @@
 #include "parser.h"
 #include "ast/nodes.h"
 #include "tokens/tokens.h"
+#include <algorithm>
 #include <climits>
 #include <memory>
 
@@ -15,6 +16,51 @@ void Parser::eat(TokenType type) {
     }
 }
 
+void Parser::note_read(const std::string& name) {
+    if (functions.empty()) return;
+    FunctionScope& scope = functions.back();
+    if (scope.locals.count(name)) return;
+    for (auto& free : scope.free_variables) {
+        if (free == name) return;
+    }
+    scope.free_variables.push_back(name);
+}
+
+void Parser::note_write(const std::string& name) {
+    if (!functions.empty()) functions.back().locals.insert(name);
+}
+
+void Parser::note_impure() {
+    if (!functions.empty()) functions.back().impure = true;
+}
+
+void Parser::resolve_captures(FunctionScope& scope, const std::unordered_set<std::string>& enclosing) {
+    FunctionDescriptor& descriptor = *scope.descriptor;
+    // Reads of outer names, and assignments to names that are not
+    // parameters: those write to the enclosing function's variable.
+    std::vector<std::string> candidates = scope.free_variables;
+    for (auto& name : scope.locals) {
+        bool is_param = std::find(descriptor.params.begin(), descriptor.params.end(), name) != descriptor.params.end();
+        bool is_free = std::find(candidates.begin(), candidates.end(), name) != candidates.end();
+        if (!is_param && !is_free) candidates.push_back(name);
+    }
+
+    std::unordered_set<std::string> visible = scope.locals;
+    for (auto& name : candidates) {
+        if (!enclosing.count(name)) continue;
+        if (name == descriptor.name) {
+            descriptor.binds_self = true;
+            continue;
+        }
+        descriptor.captured.push_back(name);
+        descriptor.self_contained = false;
+        visible.insert(name);
+    }
+    for (auto& inner : scope.nested) {
+        resolve_captures(inner, visible);
+    }
+}
+
 
 
 std::unique_ptr<ASTNode> Parser::factor() {
@@ -37,7 +83,7 @@ std::unique_ptr<ASTNode> Parser::factor() {
 
     if (token.type == TokenType::STRING) {
         eat(TokenType::STRING);
-        return std::make_unique<StringNode>(token.value);
+        return std::make_unique<StringNode>(constants.intern(token.value));
     }
 
     if (token.type == TokenType::NIL) {
@@ -54,11 +100,52 @@ std::unique_ptr<ASTNode> Parser::factor() {
 
     if (token.type == TokenType::READ) {
         eat(TokenType::READ);
+        note_impure();
         eat(TokenType::LPAREN);
         eat(TokenType::RPAREN);
         return std::make_unique<ReadNode>();
     }
 
+    if (token.type == TokenType::LINES || token.type == TokenType::FILE_LINES) {
+        return parse_lines();
+    }
+
+    if (token.type == TokenType::READ_FILE) {
+        eat(TokenType::READ_FILE);
+        note_impure();
+        eat(TokenType::LPAREN);
+        auto inside = expr();
+        std::unique_ptr<ASTNode> offset, count;
+        if (current_token.type == TokenType::COMMA) {
+            eat(TokenType::COMMA);
+            offset = expr();
+            if (current_token.type == TokenType::COMMA) {
+                eat(TokenType::COMMA);
+                count = expr();
+            }
+        }
+        eat(TokenType::RPAREN);
+        return std::make_unique<ReadFileNode>(std::move(inside), std::move(offset), std::move(count));
+    }
+
+    if (token.type == TokenType::FILE_BYTES) {
+        eat(TokenType::FILE_BYTES);
+        note_impure();
+        eat(TokenType::LPAREN);
+        auto inside = expr();
+        std::unique_ptr<ASTNode> offset, count;
+        if (current_token.type == TokenType::COMMA) {
+            eat(TokenType::COMMA);
+            offset = expr();
+            if (current_token.type == TokenType::COMMA) {
+                eat(TokenType::COMMA);
+                count = expr();
+            }
+        }
+        eat(TokenType::RPAREN);
+        return std::make_unique<FileBytesNode>(std::move(inside), std::move(offset), std::move(count));
+    }
+
     if (token.type == TokenType::LEN) {
         eat(TokenType::LEN);
         eat(TokenType::LPAREN);
@@ -163,6 +250,40 @@ std::unique_ptr<ASTNode> Parser::factor() {
         return std::make_unique<UpperNode>(std::move(inside));
     }
 
+    if (token.type == TokenType::IS_DIGIT) {
+        eat(TokenType::IS_DIGIT);
+        eat(TokenType::LPAREN);
+        auto inside = expr();
+        eat(TokenType::RPAREN);
+        return std::make_unique<IsDigitNode>(std::move(inside));
+    }
+
+    if (token.type == TokenType::IS_ALPHA) {
+        eat(TokenType::IS_ALPHA);
+        eat(TokenType::LPAREN);
+        auto inside = expr();
+        eat(TokenType::RPAREN);
+        return std::make_unique<IsAlphaNode>(std::move(inside));
+    }
+
+    if (token.type == TokenType::TRIM) {
+        eat(TokenType::TRIM);
+        eat(TokenType::LPAREN);
+        auto inside = expr();
+        eat(TokenType::RPAREN);
+        return std::make_unique<TrimNode>(std::move(inside));
+    }
+
+    if (token.type == TokenType::COUNT) {
+        eat(TokenType::COUNT);
+        eat(TokenType::LPAREN);
+        auto s = expr();
+        eat(TokenType::COMMA);
+        auto needle = expr();
+        eat(TokenType::RPAREN);
+        return std::make_unique<CountNode>(std::move(s), std::move(needle));
+    }
+
     if (token.type == TokenType::SPLIT) {
         eat(TokenType::SPLIT);
         eat(TokenType::LPAREN);
@@ -195,8 +316,63 @@ std::unique_ptr<ASTNode> Parser::factor() {
         return std::make_unique<ReplaceNode>(std::move(s), std::move(old), std::move(new_s));
     }
 
+    if (token.type == TokenType::MAP || token.type == TokenType::FILTER || token.type == TokenType::PMAP) {
+        eat(token.type);
+        note_impure();
+        eat(TokenType::LPAREN);
+        auto list = expr();
+        eat(TokenType::COMMA);
+        auto fn = expr();
+        eat(TokenType::RPAREN);
+        if (token.type == TokenType::FILTER) return std::make_unique<FilterNode>(std::move(list), std::move(fn));
+        return std::make_unique<MapNode>(std::move(list), std::move(fn), token.type == TokenType::PMAP);
+    }
+
+    if (token.type == TokenType::REDUCE) {
+        eat(TokenType::REDUCE);
+        note_impure();
+        eat(TokenType::LPAREN);
+        auto list = expr();
+        eat(TokenType::COMMA);
+        auto fn = expr();
+        eat(TokenType::COMMA);
+        auto init = expr();
+        eat(TokenType::RPAREN);
+        return std::make_unique<ReduceNode>(std::move(list), std::move(fn), std::move(init));
+    }
+
+    if (token.type == TokenType::MEMOIZE) {
+        eat(TokenType::MEMOIZE);
+        eat(TokenType::LPAREN);
+        auto fn = expr();
+        std::unique_ptr<ASTNode> size;
+        if (current_token.type == TokenType::COMMA) {
+            eat(TokenType::COMMA);
+            size = expr();
+        }
+        eat(TokenType::RPAREN);
+        return std::make_unique<MemoizeNode>(std::move(fn), std::move(size));
+    }
+
+    if (token.type == TokenType::MEMO_STATS) {
+        eat(TokenType::MEMO_STATS);
+        eat(TokenType::LPAREN);
+        auto fn = expr();
+        eat(TokenType::RPAREN);
+        return std::make_unique<MemoStatsNode>(std::move(fn));
+    }
+
+    if (token.type == TokenType::STATS) {
+        eat(TokenType::STATS);
+        note_impure();
+        eat(TokenType::LPAREN);
+        eat(TokenType::RPAREN);
+        return std::make_unique<StatsNode>();
+    }
+
     if (token.type == TokenType::PUSH) {
         eat(TokenType::PUSH);
+        note_impure();
         eat(TokenType::LPAREN);
         auto list = expr();
         eat(TokenType::COMMA);
@@ -207,6 +383,7 @@ std::unique_ptr<ASTNode> Parser::factor() {
 
     if (token.type == TokenType::POP) {
         eat(TokenType::POP);
+        note_impure();
         eat(TokenType::LPAREN);
         auto inside = expr();
         eat(TokenType::RPAREN);
@@ -215,6 +392,7 @@ std::unique_ptr<ASTNode> Parser::factor() {
 
     if (token.type == TokenType::SORT) {
         eat(TokenType::SORT);
+        note_impure();
         eat(TokenType::LPAREN);
         auto inside = expr();
         eat(TokenType::RPAREN);
@@ -223,6 +401,7 @@ std::unique_ptr<ASTNode> Parser::factor() {
 
     if (token.type == TokenType::REMOVE) {
         eat(TokenType::REMOVE);
+        note_impure();
         eat(TokenType::LPAREN);
         auto list = expr();
         eat(TokenType::COMMA);
@@ -233,6 +412,7 @@ std::unique_ptr<ASTNode> Parser::factor() {
 
     if (token.type == TokenType::INSERT) {
         eat(TokenType::INSERT);
+        note_impure();
         eat(TokenType::LPAREN);
         auto list = expr();
         eat(TokenType::COMMA);
@@ -245,6 +425,7 @@ std::unique_ptr<ASTNode> Parser::factor() {
 
     if (token.type == TokenType::STACKTRACE) {
         eat(TokenType::STACKTRACE);
+        note_impure();
         eat(TokenType::LPAREN);
         eat(TokenType::RPAREN);
         return std::make_unique<StackTraceNode>();
@@ -280,9 +461,11 @@ std::unique_ptr<ASTNode> Parser::factor() {
     if (token.type == TokenType::VAR) {
         std::string name = token.value;
         eat(TokenType::VAR);
+        note_read(name);
 
         if (current_token.type == TokenType::LPAREN) {
             eat(TokenType::LPAREN);
+            note_impure();
             std::vector<std::unique_ptr<ASTNode>> args;
             if (current_token.type != TokenType::RPAREN) {
                 args.push_back(expr());
@@ -355,6 +538,7 @@ std::unique_ptr<ASTNode> Parser::factor() {
 
                 while (current_token.type == TokenType::LPAREN) {
                     eat(TokenType::LPAREN);
+                    note_impure();
                     std::vector<std::unique_ptr<ASTNode>> args;
                     if (current_token.type != TokenType::RPAREN) {
                         args.push_back(expr());
@@ -472,9 +656,27 @@ std::unique_ptr<ASTNode> Parser::expr() {
 }
 
 
-Parser::Parser(const std::string& text) : lexer(text), current_token(lexer.get_next_token()) {}
+Parser::Parser(const std::string& text, ConstantPool& pool, uint32_t first_line)
+    : lexer(text, first_line), current_token(lexer.get_next_token()), constants(pool) {}
 
 std::unique_ptr<ASTNode> Parser::parse() {
+    uint32_t line = current_token.line;
+    uint32_t column = current_token.column;
+    std::unique_ptr<ASTNode> node;
+    try {
+        node = parse_statement();
+    } catch (const LocatedError&) {
+        throw;
+    } catch (const std::exception& e) {
+        throw LocatedError(e.what(), line);
+    }
+    node->line = line;
+    node->column = column;
+    statement_lines.push_back(line);
+    return node;
+}
+
+std::unique_ptr<ASTNode> Parser::parse_statement() {
     if (current_token.type == TokenType::BREAK) {
         eat(TokenType::BREAK);
         return std::make_unique<BreakNode>();
@@ -494,6 +696,7 @@ std::unique_ptr<ASTNode> Parser::parse() {
     }
     else if (current_token.type == TokenType::PRINT) {
         eat(TokenType::PRINT);
+        note_impure();
         eat(TokenType::LPAREN);
         auto arg = expr();
         eat(TokenType::RPAREN); 
@@ -501,6 +704,7 @@ std::unique_ptr<ASTNode> Parser::parse() {
     }
     else if (current_token.type == TokenType::PRINTLN) {
         eat(TokenType::PRINTLN);
+        note_impure();
         eat(TokenType::LPAREN);
         auto arg = expr();
         eat(TokenType::RPAREN); 
@@ -531,6 +735,8 @@ std::unique_ptr<ASTNode> Parser::parse() {
                 default:
                     throw std::runtime_error("Unknown compound assignment operator");
             }
+            note_read(var_name);
+            note_write(var_name);
             auto varNode = std::make_unique<VariableNode>(var_name);
             auto bin = std::make_unique<BinOpNode>(std::move(varNode), binOp, std::move(right));
             return std::make_unique<AssignmentNode>(var_name, std::move(bin));
@@ -547,6 +753,8 @@ std::unique_ptr<ASTNode> Parser::parse() {
                 }
             }
             eat(TokenType::RPAREN);
+            note_read(var_name);
+            note_impure();
             auto varNode = std::make_unique<VariableNode>(var_name);
             return std::make_unique<CallNode>(
                 std::move(varNode),
@@ -558,6 +766,8 @@ std::unique_ptr<ASTNode> Parser::parse() {
             eat(TokenType::EQUAL);
             if (current_token.type == TokenType::FUNCTION) {
                 auto fnNode = parse_function();
+                fnNode->descriptor->name = var_name;
+                note_write(var_name);
                 return std::make_unique<AssignmentNode>(var_name, std::move(fnNode));
             }
             if (current_token.type == TokenType::LBRACKET) {
@@ -580,12 +790,15 @@ std::unique_ptr<ASTNode> Parser::parse() {
 
                 eat(TokenType::RBRACKET);
                 auto listNode = std::make_unique<ListNode>(std::move(elements));
+                note_write(var_name);
                 return std::make_unique<AssignmentNode>(var_name, std::move(listNode));
             }
             auto right = expr();
+            note_write(var_name);
             return std::make_unique<AssignmentNode>(var_name, std::move(right));
         }
 
+        note_read(var_name);
         return std::make_unique<VariableNode>(var_name);
     }
 
@@ -689,6 +902,7 @@ std::unique_ptr<ASTNode> Parser::parse_for() {
             }
         }
 
+        note_write(var_name);
         std::vector<std::unique_ptr<ASTNode>> body_nodes;
         while (current_token.type != TokenType::END_FOR && 
             current_token.type != TokenType::END) {
@@ -708,9 +922,30 @@ std::unique_ptr<ASTNode> Parser::parse_for() {
             std::move(step_node),
             std::move(body_nodes)
         );
+    } else if (current_token.type == TokenType::LINES || current_token.type == TokenType::FILE_LINES) {
+        auto lines_node = parse_lines();
+
+        note_write(var_name);
+        std::vector<std::unique_ptr<ASTNode>> body;
+        while (current_token.type != TokenType::END_FOR &&
+            current_token.type != TokenType::END) {
+            body.push_back(parse());
+        }
+        if (current_token.type == TokenType::END_FOR) {
+            eat(TokenType::END_FOR);
+        } else {
+            throw std::runtime_error("Expected 'end for' at end of for-statement");
+        }
+
+        return std::make_unique<ForNode>(
+            var_name,
+            std::move(lines_node),
+            std::move(body)
+        );
     } else {
         auto iterable_expr = expr();
 
+        note_write(var_name);
         std::vector<std::unique_ptr<ASTNode>> body;
         while (current_token.type != TokenType::END_FOR &&
             current_token.type != TokenType::END) {
@@ -750,7 +985,7 @@ std::unique_ptr<ASTNode> Parser::parse_while() {
                                        std::move(body_nodes));
 }
 
-std::unique_ptr<ASTNode> Parser::parse_function() {
+std::unique_ptr<FunctionNode> Parser::parse_function() {
     eat(TokenType::FUNCTION);
     std::vector<std::string> paramsList;
     eat(TokenType::LPAREN);
@@ -768,6 +1003,9 @@ std::unique_ptr<ASTNode> Parser::parse_function() {
     }
     eat(TokenType::RPAREN);
 
+    functions.emplace_back();
+    functions.back().locals.insert(paramsList.begin(), paramsList.end());
+
     std::vector<std::shared_ptr<ASTNode>> bodyNodesShared;
     while (current_token.type != TokenType::END_FUNCTION)
     {
@@ -776,14 +1014,54 @@ std::unique_ptr<ASTNode> Parser::parse_function() {
         bodyNodesShared.push_back(std::move(sharedStmt));
     }
     eat(TokenType::END_FUNCTION);
-    return std::make_unique<FunctionNode>(
+
+    FunctionScope scope = std::move(functions.back());
+    functions.pop_back();
+    for (auto& name : scope.free_variables) note_read(name);
+    // An assignment in the literal may refer to a local of this function
+    // or of one further out, which then has to be captured on the way.
+    for (auto& name : scope.locals) {
+        if (std::find(paramsList.begin(), paramsList.end(), name) == paramsList.end()) note_read(name);
+    }
+    if (scope.impure) note_impure();
+
+    auto node = std::make_unique<FunctionNode>(
         std::move(paramsList),
         std::move(bodyNodesShared)
     );
+    node->descriptor->self_contained = scope.free_variables.empty() && !scope.impure;
+    node->descriptor->free_variables = scope.free_variables;
+    scope.descriptor = node->descriptor;
+    if (functions.empty()) {
+        resolve_captures(scope, {});
+    } else {
+        functions.back().nested.push_back(std::move(scope));
+    }
+    return node;
 }
 
 std::unique_ptr<ASTNode> Parser::parse_return() {
     eat(TokenType::RETURN);
     auto node = expr();
+    if (!functions.empty()) {
+        if (auto call = dynamic_cast<CallNode*>(node.get())) call->tail = true;
+    }
     return std::make_unique<ReturnNode>(std::move(node));
+}
+
+std::unique_ptr<LinesNode> Parser::parse_lines() {
+    if (current_token.type == TokenType::FILE_LINES) {
+        eat(TokenType::FILE_LINES);
+        note_impure();
+        eat(TokenType::LPAREN);
+        auto path = expr();
+        eat(TokenType::RPAREN);
+        return std::make_unique<LinesNode>(std::move(path));
+    }
+
+    eat(TokenType::LINES);
+    note_impure();
+    eat(TokenType::LPAREN);
+    eat(TokenType::RPAREN);
+    return std::make_unique<LinesNode>();
 }
\ No newline at end of file
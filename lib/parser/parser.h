@@ -1,10 +1,42 @@
 #pragma once
 #include "lexer/lexer.h"
 #include "ast/nodes.h"
+#include "parser/constant_pool.h"
+#include <string>
+#include <unordered_set>
+#include <vector>
 
 class Parser {
     Lexer lexer;
     Token current_token;
+    ConstantPool& constants;
+
+    // What the function literal being parsed reads from outside itself and
+    // whether it does anything besides computing a value from its arguments.
+    struct FunctionScope {
+        std::unordered_set<std::string> locals;
+        std::vector<std::string> free_variables;
+        bool impure = false;
+        std::shared_ptr<FunctionDescriptor> descriptor;
+        // Literals nested in this one, kept until the outermost literal is
+        // finished and every local is known.
+        std::vector<FunctionScope> nested;
+    };
+    std::vector<FunctionScope> functions;
+
+    // Start lines of every statement parsed so far, nested ones included.
+    std::vector<uint32_t> statement_lines;
+
+    // Decides which free variables of `scope` and of the literals nested in
+    // it come from enclosing functions. `enclosing` holds the names local
+    // to or captured by the function the literal appears in.
+    static void resolve_captures(FunctionScope& scope, const std::unordered_set<std::string>& enclosing);
+
+    void note_read(const std::string& name);
+
+    void note_write(const std::string& name);
+
+    void note_impure();
 
     void eat(TokenType type);
 
@@ -28,12 +60,19 @@ class Parser {
 
     std::unique_ptr<ASTNode> parse_while();
 
-    std::unique_ptr<ASTNode> parse_function();
+    std::unique_ptr<FunctionNode> parse_function();
 
     std::unique_ptr<ASTNode> parse_return();
 
+    std::unique_ptr<LinesNode> parse_lines();
+
+    std::unique_ptr<ASTNode> parse_statement();
+
 public:
-    Parser(const std::string& text);
+    // `first_line` is the line of the whole source the text starts on.
+    Parser(const std::string& text, ConstantPool& pool, uint32_t first_line = 1);
 
     std::unique_ptr<ASTNode> parse();
+
+    const std::vector<uint32_t>& lines() const { return statement_lines; }
 };
\ No newline at end of file
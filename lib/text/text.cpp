@@ -0,0 +1,271 @@
+#include "text.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+size_t find_substring(std::string_view haystack, std::string_view needle, size_t from) {
+    const size_t n = haystack.size();
+    const size_t k = needle.size();
+    if (from > n) return std::string_view::npos;
+    if (k == 0) return from;
+    if (n - from < k) return std::string_view::npos;
+
+    const char* s = haystack.data();
+    const char* p = needle.data();
+
+    if (k == 1) {
+        auto found = static_cast<const char*>(std::memchr(s + from, p[0], n - from));
+        return found ? found - s : std::string_view::npos;
+    }
+
+    size_t i = from;
+
+#ifdef __SSE2__
+    // Compare the first and the last needle byte against 16 candidate positions
+    // at once and only run memcmp where both match.
+    const __m128i first = _mm_set1_epi8(p[0]);
+    const __m128i last = _mm_set1_epi8(p[k - 1]);
+    for (; i + k - 1 + 16 <= n; i += 16) {
+        __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + k - 1));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(block_first, first),
+                                                        _mm_cmpeq_epi8(block_last, last)));
+        while (mask != 0) {
+            unsigned bit = __builtin_ctz(mask);
+            if (std::memcmp(s + i + bit + 1, p + 1, k - 2) == 0) return i + bit;
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    while (i + k <= n) {
+        auto found = static_cast<const char*>(std::memchr(s + i, p[0], n - k + 1 - i));
+        if (!found) break;
+        i = found - s;
+        if (s[i + k - 1] == p[k - 1] && std::memcmp(s + i + 1, p + 1, k - 2) == 0) return i;
+        ++i;
+    }
+    return std::string_view::npos;
+}
+
+std::vector<std::string_view> split_views(std::string_view str, std::string_view delimiter) {
+    if (delimiter.empty()) throw std::runtime_error("split() delimiter must not be empty");
+
+    std::vector<std::string_view> tokens;
+    size_t start = 0;
+    size_t end = find_substring(str, delimiter);
+
+    while (end != std::string_view::npos) {
+        tokens.push_back(str.substr(start, end - start));
+        start = end + delimiter.size();
+        end = find_substring(str, delimiter, start);
+    }
+    tokens.push_back(str.substr(start));
+
+    return tokens;
+}
+
+std::string replace_all(std::string_view str, std::string_view from, std::string_view to) {
+    if (from.empty()) return std::string(str);
+
+    std::vector<size_t> matches;
+    for (size_t pos = find_substring(str, from); pos != std::string_view::npos;
+         pos = find_substring(str, from, pos + from.size())) {
+        matches.push_back(pos);
+    }
+
+    // libstdc++ 12 may pass the grown capacity instead of the requested size
+    // to the callback, so the callbacks below return the size they computed.
+    const size_t size = str.size() - matches.size() * from.size() + matches.size() * to.size();
+    std::string result;
+    result.resize_and_overwrite(size, [&](char* out, size_t) {
+        size_t pos = 0;
+        for (size_t match : matches) {
+            std::memcpy(out, str.data() + pos, match - pos);
+            out += match - pos;
+            std::memcpy(out, to.data(), to.size());
+            out += to.size();
+            pos = match + from.size();
+        }
+        std::memcpy(out, str.data() + pos, str.size() - pos);
+        return size;
+    });
+
+    return result;
+}
+
+// Latin Extended-A pairs an upper case letter with the code point after it,
+// starting on even code points in 0100-0137 and 014A-0177 and on odd ones in
+// 0139-0148 and 0179-017E. Dotted I and dotless i change length when mapped
+// and are left alone.
+static char32_t latin_extended_a_case(char32_t c, bool upper) {
+    bool even_pairs = (c <= 0x137 && c != 0x130 && c != 0x131) || (c >= 0x14A && c <= 0x177);
+    bool odd_pairs = (c >= 0x139 && c <= 0x148) || (c >= 0x179 && c <= 0x17E);
+    if (!even_pairs && !odd_pairs) return c;
+    bool is_upper = (c % 2 == 0) == even_pairs;
+    if (is_upper == upper) return c;
+    return upper ? c - 1 : c + 1;
+}
+
+// Case mapping of the letters UTF-8 encodes in two bytes that have a
+// two-byte counterpart: Latin-1, Latin Extended-A, Greek and Cyrillic.
+// Anything else is returned unchanged.
+static char32_t two_byte_case(char32_t c, bool upper) {
+    if (c >= 0x100 && c <= 0x17F && c != 0x178) return latin_extended_a_case(c, upper);
+    if (upper) {
+        if (c >= 0xE0 && c <= 0xFE && c != 0xF7) return c - 0x20;
+        if (c == 0xFF) return 0x178;
+        if (c >= 0x3B1 && c <= 0x3CB && c != 0x3C2) return c - 0x20;
+        if (c == 0x3C2) return 0x3A3;
+        if (c == 0x3AC) return 0x386;
+        if (c >= 0x3AD && c <= 0x3AF) return c - 0x25;
+        if (c == 0x3CC) return 0x38C;
+        if (c == 0x3CD || c == 0x3CE) return c - 0x3F;
+        if (c >= 0x430 && c <= 0x44F) return c - 0x20;
+        if (c >= 0x450 && c <= 0x45F) return c - 0x50;
+    } else {
+        if (c >= 0xC0 && c <= 0xDE && c != 0xD7) return c + 0x20;
+        if (c == 0x178) return 0xFF;
+        if (c >= 0x391 && c <= 0x3AB && c != 0x3A2) return c + 0x20;
+        if (c == 0x386) return 0x3AC;
+        if (c >= 0x388 && c <= 0x38A) return c + 0x25;
+        if (c == 0x38C) return 0x3CC;
+        if (c == 0x38E || c == 0x38F) return c + 0x3F;
+        if (c >= 0x410 && c <= 0x42F) return c + 0x20;
+        if (c >= 0x400 && c <= 0x40F) return c + 0x50;
+    }
+    return c;
+}
+
+// Converts the character at in[i] into out[i] and returns its length. Only
+// two-byte UTF-8 letters are decoded; longer sequences and stray bytes are
+// copied a byte at a time.
+template <char From, char To>
+static size_t convert_char(const char* in, size_t size, size_t i, char* out) {
+    unsigned char lead = in[i];
+    if (lead < 0x80) {
+        out[i] = (in[i] >= From && in[i] <= To) ? static_cast<char>(in[i] ^ 0x20) : in[i];
+        return 1;
+    }
+    unsigned char next = i + 1 < size ? in[i + 1] : 0;
+    if (lead < 0xC2 || lead > 0xDF || (next & 0xC0) != 0x80) {
+        out[i] = in[i];
+        return 1;
+    }
+    char32_t c = two_byte_case(((lead & 0x1F) << 6) | (next & 0x3F), From == 'a');
+    out[i] = static_cast<char>(0xC0 | (c >> 6));
+    out[i + 1] = static_cast<char>(0x80 | (c & 0x3F));
+    return 2;
+}
+
+template <char From, char To>
+static std::string convert_case(std::string_view str) {
+    const size_t size = str.size();
+    std::string result;
+    result.resize_and_overwrite(size, [&](char* out, size_t) {
+        const char* in = str.data();
+        size_t i = 0;
+        while (i < size) {
+#ifdef __SSE2__
+            // ASCII text is converted 16 bytes at a time, until a block
+            // holds a byte >= 0x80.
+            const __m128i lo = _mm_set1_epi8(From - 1);
+            const __m128i hi = _mm_set1_epi8(To + 1);
+            const __m128i bit = _mm_set1_epi8(0x20);
+            for (; i + 16 <= size; i += 16) {
+                __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                if (_mm_movemask_epi8(c)) break;
+                __m128i in_range = _mm_and_si128(_mm_cmpgt_epi8(c, lo), _mm_cmplt_epi8(c, hi));
+                __m128i flip = _mm_and_si128(in_range, bit);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_xor_si128(c, flip));
+            }
+#endif
+            // The next 16 bytes, or the tail, one character at a time.
+            for (size_t stop = std::min(size, i + 16); i < stop;) {
+                i += convert_char<From, To>(in, size, i, out);
+            }
+        }
+        return size;
+    });
+    return result;
+}
+
+std::string lower_case(std::string_view str) {
+    return convert_case<'A', 'Z'>(str);
+}
+
+std::string upper_case(std::string_view str) {
+    return convert_case<'a', 'z'>(str);
+}
+
+template <typename Pred>
+static bool all_of_class(std::string_view str, Pred pred, char lo1, char hi1, char lo2, char hi2) {
+    if (str.empty()) return false;
+
+    const char* s = str.data();
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128i l1 = _mm_set1_epi8(lo1 - 1);
+    const __m128i h1 = _mm_set1_epi8(hi1 + 1);
+    const __m128i l2 = _mm_set1_epi8(lo2 - 1);
+    const __m128i h2 = _mm_set1_epi8(hi2 + 1);
+    for (; i + 16 <= str.size(); i += 16) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        __m128i r1 = _mm_and_si128(_mm_cmpgt_epi8(c, l1), _mm_cmplt_epi8(c, h1));
+        __m128i r2 = _mm_and_si128(_mm_cmpgt_epi8(c, l2), _mm_cmplt_epi8(c, h2));
+        if (_mm_movemask_epi8(_mm_or_si128(r1, r2)) != 0xFFFF) return false;
+    }
+#endif
+    for (; i < str.size(); ++i) {
+        if (!pred(s[i])) return false;
+    }
+    return true;
+}
+
+bool all_digits(std::string_view str) {
+    return all_of_class(str, [](char c) { return c >= '0' && c <= '9'; }, '0', '9', '0', '9');
+}
+
+bool all_alpha(std::string_view str) {
+    return all_of_class(str, [](char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); },
+                        'a', 'z', 'A', 'Z');
+}
+
+std::string_view trim_view(std::string_view str) {
+    constexpr std::string_view whitespace = " \t\n\r\f\v";
+    size_t first = str.find_first_not_of(whitespace);
+    if (first == std::string_view::npos) return {};
+    size_t last = str.find_last_not_of(whitespace);
+    return str.substr(first, last - first + 1);
+}
+
+size_t count_substring(std::string_view haystack, std::string_view needle) {
+    if (needle.empty()) throw std::runtime_error("count() substring must not be empty");
+
+    size_t count = 0;
+    if (needle.size() == 1) {
+        const char* s = haystack.data();
+        size_t i = 0;
+#ifdef __SSE2__
+        const __m128i target = _mm_set1_epi8(needle[0]);
+        for (; i + 16 <= haystack.size(); i += 16) {
+            __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+            count += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(c, target)));
+        }
+#endif
+        for (; i < haystack.size(); ++i) {
+            count += s[i] == needle[0];
+        }
+        return count;
+    }
+
+    for (size_t pos = find_substring(haystack, needle); pos != std::string_view::npos;
+         pos = find_substring(haystack, needle, pos + needle.size())) {
+        ++count;
+    }
+    return count;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+size_t find_substring(std::string_view haystack, std::string_view needle, size_t from = 0);
+
+std::vector<std::string_view> split_views(std::string_view str, std::string_view delimiter);
+
+std::string replace_all(std::string_view str, std::string_view from, std::string_view to);
+
+// Case conversion of ASCII and of the Latin-1, Latin Extended-A, Greek and
+// Cyrillic letters; other characters are kept. The result is as long as
+// the input.
+std::string lower_case(std::string_view str);
+
+std::string upper_case(std::string_view str);
+
+bool all_digits(std::string_view str);
+
+bool all_alpha(std::string_view str);
+
+std::string_view trim_view(std::string_view str);
+
+size_t count_substring(std::string_view haystack, std::string_view needle);
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <string>
 
 enum class TokenType {
@@ -67,11 +68,26 @@ enum class TokenType {
     TO_STRING,
     LOWER,
     UPPER,
+    IS_DIGIT,
+    IS_ALPHA,
+    TRIM,
+    COUNT,
     SPLIT,
     JOIN,
     REPLACE,
+    MAP,
+    FILTER,
+    REDUCE,
+    PMAP,
+    MEMOIZE,
+    MEMO_STATS,
+    STATS,
     PRINTLN,
     READ,
+    LINES,
+    READ_FILE,
+    FILE_LINES,
+    FILE_BYTES,
     STACKTRACE,
     BREAK,
     CONTINUE,
@@ -138,6 +154,9 @@ struct Token {
     Token();
     TokenType type;
     std::string value;
+    // Where the token starts, both counted from 1.
+    uint32_t line = 0;
+    uint32_t column = 0;
     Token(TokenType t, const std::string& v = "");
 };
 
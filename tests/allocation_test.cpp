@@ -0,0 +1,77 @@
+#include "lib/interpreter/interpreter.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<bool> counting{false};
+static std::atomic<size_t> allocations{0};
+
+void* operator new(std::size_t size) {
+    if (counting) ++allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+// GCC sees free() on memory from operator new and does not know that the
+// operator new in question is the replacement above, which uses malloc().
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#pragma GCC diagnostic pop
+
+class DiscardBuffer : public std::streambuf {
+protected:
+    int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+static size_t count_allocations(const std::string& code) {
+    DiscardBuffer buffer;
+    std::ostream output(&buffer);
+    std::istringstream input(code);
+
+    allocations = 0;
+    counting = true;
+    bool ok = interpret(input, output);
+    counting = false;
+
+    EXPECT_TRUE(ok);
+    return allocations;
+}
+
+TEST(AllocationTestSuite, StringLiteralInLoopTest) {
+    std::string loop = R"(
+        for i in range(%d)
+            print("literal in a loop body")
+        end for
+    )";
+
+    std::string short_loop = loop, long_loop = loop;
+    short_loop.replace(short_loop.find("%d"), 2, "1000");
+    long_loop.replace(long_loop.find("%d"), 2, "5000");
+
+    ASSERT_EQ(count_allocations(short_loop), count_allocations(long_loop));
+}
+
+TEST(AllocationTestSuite, LiteralIsNotMutatedTest) {
+    std::string code = R"(
+        for i in range(3)
+            s = "a"
+            s += "b"
+            print(s)
+        end for
+        t = s
+        t *= 2
+        print(" " + s)
+    )";
+
+    std::string expected = "ababab ab";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
@@ -0,0 +1,229 @@
+#include "lib/interpreter/interpreter.h"
+#include "lib/interpreter/script_pool.h"
+#include <gtest/gtest.h>
+
+static std::string run_with(const Budget& budget, const std::string& code, bool& ok) {
+    std::istringstream input(code);
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_budget(budget);
+    ok = interpreter.run(*Program::compile(input));
+    return output.str();
+}
+
+TEST(BudgetTestSuite, StepLimitTest) {
+    std::string code = R"(
+        for i in range(10)
+            print(i)
+        end for
+    )";
+
+    Budget budget;
+    budget.max_steps = 10;
+    bool ok;
+    ASSERT_EQ(run_with(budget, code, ok), "0123456789");
+    ASSERT_TRUE(ok);
+
+    budget.max_steps = 9;
+    ASSERT_EQ(run_with(budget, code, ok), "012345678Error: Step limit exceeded (line 2)\n");
+    ASSERT_FALSE(ok);
+}
+
+TEST(BudgetTestSuite, RunawayLoopTest) {
+    std::string code = R"(
+        print("start")
+        x = 0
+        while true
+            x += 1
+        end while
+    )";
+
+    Budget budget;
+    budget.max_steps = 1000000;
+    bool ok;
+    ASSERT_EQ(run_with(budget, code, ok), "startError: Step limit exceeded (line 4)\n");
+    ASSERT_FALSE(ok);
+}
+
+TEST(BudgetTestSuite, TimeoutTest) {
+    std::string code = R"(
+        x = 0
+        while true
+            x += 1
+        end while
+    )";
+
+    Budget budget;
+    budget.timeout = std::chrono::milliseconds(50);
+    bool ok;
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(run_with(budget, code, ok), "Error: Time limit exceeded (line 3)\n");
+    ASSERT_FALSE(ok);
+    ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+TEST(BudgetTestSuite, CallDepthTest) {
+    std::string code = R"(
+        down = function(n)
+            if n == 0 then
+                return 0
+            end if
+            return 1 + down(n - 1)
+        end function
+        print(down(49))
+        print(down(50))
+    )";
+
+    Budget budget;
+    budget.max_call_depth = 50;
+    bool ok;
+    ASSERT_EQ(run_with(budget, code, ok), "49Error: Call depth limit exceeded (line 6)\n");
+    ASSERT_FALSE(ok);
+}
+
+TEST(BudgetTestSuite, AllocationLimitTest) {
+    std::string code = R"(
+        s = "ab"
+        while true
+            s = s + s
+        end while
+    )";
+
+    Budget budget;
+    budget.max_alloc_bytes = 1 << 20;
+    bool ok;
+    ASSERT_EQ(run_with(budget, code, ok), "Error: Allocation limit exceeded (line 4)\n");
+    ASSERT_FALSE(ok);
+
+    code = R"(
+        xs = []
+        for i in range(1000000)
+            push(xs, i)
+        end for
+    )";
+    ASSERT_EQ(run_with(budget, code, ok), "Error: Allocation limit exceeded (line 4)\n");
+    ASSERT_FALSE(ok);
+}
+
+TEST(BudgetTestSuite, BudgetIsPerRunTest) {
+    std::string code = R"(
+        for i in range(6)
+            print(i)
+        end for
+    )";
+
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    Budget budget;
+    budget.max_steps = 8;
+    interpreter.set_budget(budget);
+
+    for (int run = 0; run < 3; ++run) {
+        std::istringstream input(code);
+        ASSERT_TRUE(interpreter.run(*Program::compile(input)));
+    }
+    ASSERT_EQ(output.str(), "012345012345012345");
+}
+
+TEST(BudgetTestSuite, ParallelMapTest) {
+    std::string code = R"(
+        spin = function(x)
+            while x == x
+                x += 0
+            end while
+            return x
+        end function
+        xs = [1, 2, 3, 4, 5, 6, 7, 8]
+        ys = pmap(xs, spin)
+    )";
+
+    Budget budget;
+    budget.max_steps = 100000;
+    bool ok;
+    ASSERT_EQ(run_with(budget, code, ok), "Error: Step limit exceeded (line 3)\n");
+    ASSERT_FALSE(ok);
+}
+
+TEST(BudgetTestSuite, ParallelMapSharesBudgetTest) {
+    std::string code = R"(
+        work = function(n)
+            i = 0
+            while i < n
+                i += 1
+            end while
+            return i
+        end function
+        ys = pmap([1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000], work)
+        print(len(ys))
+        for i in range(%d)
+            x = i
+        end for
+    )";
+
+    auto run = [&](uint64_t max_steps, size_t loop, bool& ok) {
+        std::string script = code;
+        script.replace(script.find("%d"), 2, std::to_string(loop));
+        std::istringstream input(script);
+        std::ostringstream output;
+        Interpreter interpreter(output);
+        Budget budget;
+        budget.max_steps = max_steps;
+        interpreter.set_budget(budget);
+        interpreter.set_threads(4);
+        ok = interpreter.run(*Program::compile(input));
+        return output.str();
+    };
+
+    // Each call fits the limit on its own; the eight of them together do not.
+    bool ok;
+    ASSERT_TRUE(run(5000, 0, ok).starts_with("Error: Step limit exceeded"));
+    ASSERT_FALSE(ok);
+
+    ASSERT_EQ(run(20000, 0, ok), "8");
+    ASSERT_TRUE(ok);
+
+    // The steps taken by the workers count against what the run has left.
+    ASSERT_EQ(run(20000, 15000, ok), "8Error: Step limit exceeded (line 11)\n");
+    ASSERT_FALSE(ok);
+}
+
+TEST(BudgetTestSuite, ParallelMapSharesAllocationLimitTest) {
+    std::string code = R"(
+        grow = function(n)
+            s = "x"
+            while len(s) < n
+                s = s + s
+            end while
+            return len(s)
+        end function
+        ys = pmap([65536, 65536, 65536, 65536], grow)
+        print(ys)
+    )";
+
+    Budget budget;
+    budget.max_alloc_bytes = 300000;
+    std::istringstream input(code);
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_budget(budget);
+    interpreter.set_threads(4);
+
+    ASSERT_FALSE(interpreter.run(*Program::compile(input)));
+    ASSERT_TRUE(output.str().starts_with("Error: Allocation limit exceeded")) << output.str();
+}
+
+TEST(BudgetTestSuite, ScriptPoolTest) {
+    std::string good = "print(1 + 1)\n";
+    std::string bad = "while true\nx = 1\nend while\n";
+
+    ScriptPool pool(2);
+    Budget budget;
+    budget.timeout = std::chrono::milliseconds(50);
+    pool.set_budget(budget);
+    auto results = pool.run({{good, ""}, {bad, ""}, {good, ""}});
+
+    ASSERT_EQ(results[0].output, "2");
+    ASSERT_EQ(results[1].output, "Error: Time limit exceeded (line 1)\n");
+    ASSERT_FALSE(results[1].ok);
+    ASSERT_EQ(results[2].output, "2");
+}
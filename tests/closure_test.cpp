@@ -0,0 +1,151 @@
+#include "lib/interpreter/interpreter.h"
+#include <gtest/gtest.h>
+
+TEST(ClosureTestSuite, CounterTest) {
+    std::string code = R"(
+        make_counter = function()
+            n = 0
+            next = function()
+                n = n + 1
+                return n
+            end function
+            return next
+        end function
+        a = make_counter()
+        b = make_counter()
+        a()
+        a()
+        b()
+        print(a())
+        print(b())
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output)) << output.str();
+    ASSERT_EQ(output.str(), "32");
+}
+
+TEST(ClosureTestSuite, CaptureByReferenceTest) {
+    std::string code = R"(
+        outer = function()
+            x = 1
+            get = function()
+                return x
+            end function
+            x = 2
+            first = get()
+            set = function(v)
+                x = v
+            end function
+            set(3)
+            return [first, get(), x]
+        end function
+        print(outer())
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output)) << output.str();
+    ASSERT_EQ(output.str(), "[2, 3, 3]");
+}
+
+TEST(ClosureTestSuite, NestedCaptureTest) {
+    std::string code = R"(
+        adder = function(a)
+            middle = function(b)
+                inner = function(c)
+                    return a + b + c
+                end function
+                return inner
+            end function
+            return middle
+        end function
+        add_one = adder(1)
+        add_three = add_one(2)
+        print(add_three(10))
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output)) << output.str();
+    ASSERT_EQ(output.str(), "13");
+}
+
+TEST(ClosureTestSuite, CalleeDoesNotSeeCallerLocalsTest) {
+    std::string code = R"(
+        show = function()
+            return secret
+        end function
+        caller = function()
+            secret = 1
+            return show()
+        end function
+        print(caller())
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_FALSE(interpret(input, output));
+    ASSERT_EQ(output.str(), "Error: Undefined variable: secret (line 3)\n");
+}
+
+TEST(ClosureTestSuite, GlobalsStayVisibleTest) {
+    std::string code = R"(
+        scale = 10
+        apply = function(x)
+            scale = 2
+            return helper(x)
+        end function
+        helper = function(x)
+            return x * scale
+        end function
+        print(apply(3))
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output)) << output.str();
+    ASSERT_EQ(output.str(), "30");
+}
+
+TEST(ClosureTestSuite, LocalRecursiveHelperTest) {
+    std::string code = R"(
+        total = function(limit)
+            loop = function(i, acc)
+                if i > limit then
+                    return acc
+                end if
+                return loop(i + 1, acc + i)
+            end function
+            return loop(1, 0)
+        end function
+        print(total(10000))
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output)) << output.str();
+    ASSERT_EQ(output.str(), "50005000");
+}
+
+TEST(ClosureTestSuite, CallbackCapturesLocalTest) {
+    std::string code = R"(
+        scaled = function(values, factor)
+            return map(values, function(x) return x * factor end function)
+        end function
+        print(scaled([1, 2, 3], 5))
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output)) << output.str();
+    ASSERT_EQ(output.str(), "[5, 10, 15]");
+}
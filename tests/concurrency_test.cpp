@@ -0,0 +1,102 @@
+#include "lib/interpreter/interpreter.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+TEST(ConcurrencyTestSuite, IndependentInterpretersTest) {
+    const int kJobs = 64;
+    std::string code = R"(
+        depth = function(n)
+            if n == 0 then
+                return len(stacktrace())
+            end if
+            d = depth(n - 1)
+            return d
+        end function
+
+        id = read()
+        total = 0
+        for i in range(2000)
+            total += rnd(1) + 1
+        end for
+        println(id + " " + to_string(total) + " " + to_string(depth(20)))
+    )";
+
+    std::vector<std::string> outputs(kJobs);
+    std::vector<int> results(kJobs);
+    std::atomic<int> next_job{0};
+
+    unsigned workers = std::max(4u, std::thread::hardware_concurrency());
+    std::vector<std::thread> pool;
+    for (unsigned w = 0; w < workers; ++w) {
+        pool.emplace_back([&] {
+            for (int job = next_job++; job < kJobs; job = next_job++) {
+                std::istringstream input(code);
+                std::istringstream script_input("job" + std::to_string(job) + "\n");
+                std::ostringstream output;
+                results[job] = interpret(input, output, script_input);
+                outputs[job] = output.str();
+            }
+        });
+    }
+    for (auto& t : pool) t.join();
+
+    for (int job = 0; job < kJobs; ++job) {
+        ASSERT_TRUE(results[job]) << outputs[job];
+        ASSERT_EQ(outputs[job], "job" + std::to_string(job) + " 2000 21\n");
+    }
+}
+
+TEST(ConcurrencyTestSuite, ReadFromScriptInputTest) {
+    std::string code = R"(
+        first = read()
+        for line in lines()
+            print(line + ";")
+        end for
+        print(first)
+    )";
+
+    std::istringstream input(code);
+    std::istringstream script_input("header\na\nb\n");
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output, script_input));
+    ASSERT_EQ(output.str(), "a;b;header");
+}
+
+TEST(ConcurrencyTestSuite, ReadFollowsRedirectedCinTest) {
+    std::string code = R"(
+        for line in lines()
+            print(line + ";")
+        end for
+    )";
+
+    std::istringstream input(code);
+    std::istringstream script_input("a\nb\n");
+    std::ostringstream output;
+
+    std::streambuf* stdin_buffer = std::cin.rdbuf(script_input.rdbuf());
+    bool ok = interpret(input, output);
+    std::cin.rdbuf(stdin_buffer);
+
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(output.str(), "a;b;");
+}
+
+TEST(ConcurrencyTestSuite, LinesAsVariableTest) {
+    std::string code = R"(
+        lines = [1, 2]
+        push(lines, len(lines()))
+        print(lines)
+    )";
+
+    std::istringstream input(code);
+    std::istringstream script_input("a\nb\nc\n");
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output, script_input));
+    ASSERT_EQ(output.str(), "[1, 2, 3]");
+}
@@ -0,0 +1,112 @@
+#include "lib/interpreter/interpreter.h"
+#include "lib/interpreter/coverage.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+const char* kScript = R"(
+square = function(x)
+    return x * x
+end function
+total = 0
+for i in range(0, 5, 1)
+    if i % 2 == 0 then
+        total += square(i)
+    else
+        total -= 1
+    end if
+end for
+if total < 0 then
+    print("negative")
+end if
+print(total)
+)";
+
+bool run(Interpreter& interpreter, const std::string& code) {
+    std::istringstream input(code);
+    return interpreter.run(*Program::compile(input));
+}
+
+}
+
+TEST(CoverageTestSuite, LineCountsTest) {
+    Coverage coverage;
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_coverage(&coverage);
+    ASSERT_TRUE(run(interpreter, kScript)) << output.str();
+    ASSERT_EQ(output.str(), "18");
+
+    ASSERT_EQ(coverage.hits(2), 1u);
+    ASSERT_EQ(coverage.hits(3), 3u);
+    ASSERT_EQ(coverage.hits(6), 1u);
+    ASSERT_EQ(coverage.hits(7), 5u);
+    ASSERT_EQ(coverage.hits(8), 3u);
+    ASSERT_EQ(coverage.hits(10), 2u);
+    ASSERT_EQ(coverage.hits(14), 0u);
+    ASSERT_EQ(coverage.hits(16), 1u);
+    // Lines with nothing but `end ...` hold no statement.
+    ASSERT_EQ(coverage.lines_found(), 10u);
+    ASSERT_EQ(coverage.lines_hit(), 9u);
+}
+
+TEST(CoverageTestSuite, LcovTest) {
+    Coverage coverage;
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_coverage(&coverage);
+    ASSERT_TRUE(run(interpreter, "x = 1\nif x > 1 then\n    x = 2\nend if\n")) << output.str();
+
+    std::ostringstream lcov;
+    coverage.write_lcov(lcov, "script.is");
+    ASSERT_EQ(lcov.str(),
+        "TN:\n"
+        "SF:script.is\n"
+        "DA:1,1\n"
+        "DA:2,1\n"
+        "DA:3,0\n"
+        "LF:3\n"
+        "LH:2\n"
+        "end_of_record\n");
+
+    std::ostringstream json;
+    coverage.write_json(json, "script.is");
+    ASSERT_EQ(json.str(), "{\"source\": \"script.is\", \"lines\": {\"1\": 1, \"2\": 1, \"3\": 0}}\n");
+}
+
+TEST(CoverageTestSuite, ParallelWorkersTest) {
+    std::string code = R"(
+        inc = function(x)
+            return x + 1
+        end function
+        xs = []
+        for i in range(0, 100, 1)
+            push(xs, i)
+        end for
+        r = pmap(xs, inc)
+        print(len(r))
+    )";
+
+    Coverage coverage;
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_threads(4);
+    interpreter.set_coverage(&coverage);
+    ASSERT_TRUE(run(interpreter, code)) << output.str();
+    ASSERT_EQ(output.str(), "100");
+    ASSERT_EQ(coverage.hits(3), 100u);
+}
+
+TEST(CoverageTestSuite, RunsAccumulateTest) {
+    Coverage coverage;
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_coverage(&coverage);
+    ASSERT_TRUE(run(interpreter, kScript));
+    ASSERT_TRUE(run(interpreter, kScript));
+    ASSERT_EQ(coverage.hits(7), 10u);
+
+    interpreter.set_coverage(nullptr);
+    ASSERT_TRUE(run(interpreter, kScript));
+    ASSERT_EQ(coverage.hits(7), 10u);
+}
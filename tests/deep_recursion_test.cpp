@@ -0,0 +1,78 @@
+#include "lib/interpreter/interpreter.h"
+#include <gtest/gtest.h>
+
+TEST(DeepRecursionTestSuite, HundredThousandLevelsTest) {
+    std::string code = R"(
+        down = function(self, n)
+            if n == 0 then
+                return 0
+            end if
+            return self(self, n - 1) + 1
+        end function
+        print(down(down, 100000))
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output)) << output.str();
+    ASSERT_EQ(output.str(), "100000");
+}
+
+TEST(DeepRecursionTestSuite, ErrorUnwindsThroughSegmentsTest) {
+    std::string code = R"(
+        down = function(self, n)
+            if n == 0 then
+                return 1 / 0
+            end if
+            return self(self, n - 1) + 1
+        end function
+        print("before")
+        print(down(down, 50000))
+        print("after")
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_FALSE(interpret(input, output));
+    ASSERT_EQ(output.str().substr(0, 13), "beforeError: ");
+
+    std::istringstream again(R"(
+        down = function(self, n)
+            if n == 0 then
+                return len(stacktrace())
+            end if
+            depth = self(self, n - 1)
+            return depth
+        end function
+        print(down(down, 30000))
+    )");
+    std::ostringstream again_output;
+    ASSERT_TRUE(interpret(again, again_output));
+    ASSERT_EQ(again_output.str(), "30001");
+}
+
+TEST(DeepRecursionTestSuite, StackOverflowIsScriptErrorTest) {
+    std::string code = R"(
+        forever = function(self)
+            return self(self) + 1
+        end function
+        print("start")
+        forever(forever)
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    Budget budget;
+    budget.max_stack_bytes = 32 << 20;
+    interpreter.set_budget(budget);
+
+    ASSERT_FALSE(interpreter.run(*Program::compile(input)));
+    ASSERT_EQ(output.str(), "startError: Stack overflow (line 3)\n");
+
+    std::istringstream next("print(\"still alive\")");
+    ASSERT_TRUE(interpreter.run(*Program::compile(next)));
+    ASSERT_EQ(output.str(), "startError: Stack overflow (line 3)\nstill alive");
+}
@@ -0,0 +1,116 @@
+#include "lib/interpreter/interpreter.h"
+#include <gtest/gtest.h>
+#include <fstream>
+
+// Each test gets its own file: ctest runs the tests as separate processes,
+// possibly at the same time.
+static std::string write_temp_file(const std::string& contents) {
+    const testing::TestInfo* test = testing::UnitTest::GetInstance()->current_test_info();
+    std::string path = testing::TempDir() + "itmoscript_" + test->test_suite_name() + "_" + test->name() + ".txt";
+    std::ofstream file(path, std::ios::binary);
+    file << contents;
+    return path;
+}
+
+TEST(FileFuncsTestSuite, ReadFileTest) {
+    std::string path = write_temp_file("hello\nworld\n");
+    std::string code = "s = read_file(\"" + path + "\")\n"
+                       "print(len(s))\n";
+
+    std::string expected = "12";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+TEST(FileFuncsTestSuite, FileLinesTest) {
+    std::string path = write_temp_file("a,b\nc,d\ne");
+    std::string code = "for line in file_lines(\"" + path + "\")\n"
+                       "    print(join(split(line, \",\"), \"-\"))\n"
+                       "    print(\" \")\n"
+                       "end for\n"
+                       "all = file_lines(\"" + path + "\")\n"
+                       "print(len(all))\n";
+
+    std::string expected = "a-b c-d e 3";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+TEST(FileFuncsTestSuite, FileBytesTest) {
+    std::string path = write_temp_file("AZ\n");
+    std::string code = "print(file_bytes(\"" + path + "\"))\n";
+
+    std::string expected = "[65, 90, 10]";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+TEST(FileFuncsTestSuite, MissingFileTest) {
+    std::string code = R"(
+        s = read_file("/nonexistent/itmoscript.txt")
+        print(239)
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_FALSE(interpret(input, output));
+    ASSERT_FALSE(output.str().ends_with("239"));
+}
+
+TEST(FileFuncsTestSuite, FileWindowTest) {
+    std::string path = write_temp_file("0123456789");
+    std::string code = "path = \"" + path + "\"\n"
+                       "println(read_file(path, 3, 4))\n"
+                       "println(read_file(path, 8))\n"
+                       "println(file_bytes(path, 1, 2))\n"
+                       "println(file_bytes(path, 20, 5))\n"
+                       "println(len(read_file(path, 0, 100)))\n";
+
+    std::string expected = "3456\n89\n[49, 50]\n[]\n10\n";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+TEST(FileFuncsTestSuite, NegativeOffsetTest) {
+    std::string path = write_temp_file("0123456789");
+    std::string code = "s = read_file(\"" + path + "\", -1)\n"
+                       "print(239)\n";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_FALSE(interpret(input, output));
+    ASSERT_FALSE(output.str().ends_with("239"));
+}
+
+TEST(FileFuncsTestSuite, FileFuncNamesAsVariablesTest) {
+    std::string code = R"(
+        read_file = 1
+        file_lines = 2
+        file_bytes = read_file + file_lines
+        print(file_bytes)
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), "3");
+}
@@ -0,0 +1,120 @@
+#include "lib/interpreter/interpreter.h"
+#include "lib/interpreter/heap_profiler.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+bool run(Interpreter& interpreter, const std::string& code) {
+    std::istringstream input(code);
+    return interpreter.run(*Program::compile(input));
+}
+
+const HeapSite* find_site(const HeapSnapshot& heap, uint32_t line, HeapKind kind) {
+    for (auto& site : heap.sites) {
+        if (site.line == line && site.kind == kind) return &site;
+    }
+    return nullptr;
+}
+
+}
+
+TEST(HeapProfilerTestSuite, LiveValuesBySiteTest) {
+    std::string code = R"(
+big = "ab" * 10000
+xs = []
+for i in range(0, 100, 1)
+    push(xs, i)
+end for
+tmp = "x" * 50000
+tmp = 0
+square = function(x)
+    return x * x
+end function
+fast = memoize(square)
+print(fast(3))
+)";
+
+    HeapProfiler heap;
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_heap_profiler(&heap);
+    ASSERT_TRUE(run(interpreter, code)) << output.str();
+    ASSERT_EQ(output.str(), "9");
+
+    HeapSnapshot snapshot = heap.snapshot();
+    ASSERT_FALSE(snapshot.sites.empty());
+    ASSERT_EQ(snapshot.sites[0].line, 2u);
+    ASSERT_GE(snapshot.sites[0].bytes, 20000u);
+
+    const HeapSite* list = find_site(snapshot, 3, HeapKind::List);
+    ASSERT_NE(list, nullptr);
+    ASSERT_EQ(list->objects, 1u);
+    ASSERT_GE(list->bytes, 100 * sizeof(Value));
+
+    // The 50000 character string was freed when tmp was reassigned.
+    ASSERT_EQ(find_site(snapshot, 7, HeapKind::String), nullptr);
+    ASSERT_EQ(heap.allocations(HeapKind::String), 2u);
+
+    const HeapSite* memo = find_site(snapshot, 12, HeapKind::Function);
+    ASSERT_NE(memo, nullptr);
+    ASSERT_EQ(snapshot.objects[static_cast<size_t>(HeapKind::Function)], 1u);
+    ASSERT_LT(snapshot.total_bytes(), 50000u);
+}
+
+TEST(HeapProfilerTestSuite, CallsAttributeToTheirOwnLinesTest) {
+    std::string code = R"(
+pair = function()
+    return [1, 2]
+end function
+r = [pair(), [3]]
+)";
+
+    HeapProfiler heap;
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_heap_profiler(&heap);
+    ASSERT_TRUE(run(interpreter, code)) << output.str();
+
+    HeapSnapshot snapshot = heap.snapshot();
+    const HeapSite* inner = find_site(snapshot, 3, HeapKind::List);
+    const HeapSite* outer = find_site(snapshot, 5, HeapKind::List);
+    ASSERT_NE(inner, nullptr);
+    ASSERT_NE(outer, nullptr);
+    ASSERT_EQ(inner->objects, 1u);
+    ASSERT_EQ(outer->objects, 2u);
+}
+
+TEST(HeapProfilerTestSuite, ReportTest) {
+    HeapProfiler heap;
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_heap_profiler(&heap);
+    ASSERT_TRUE(run(interpreter, "s = \"abc\" * 1000\nl = [s, s]\n")) << output.str();
+
+    std::ostringstream report;
+    heap.write_report(report, 1);
+    std::istringstream lines(report.str());
+    std::vector<std::string> rows;
+    std::string line;
+    while (std::getline(lines, line)) rows.push_back(line);
+
+    // Kinds, then a blank line and the single largest site.
+    ASSERT_EQ(rows.size(), 7u);
+    ASSERT_EQ(rows[0].rfind("kind", 0), 0u);
+    ASSERT_EQ(rows[1].rfind("string", 0), 0u);
+    ASSERT_EQ(rows[5].rfind("line", 0), 0u);
+    ASSERT_EQ(rows[6].rfind("1         string", 0), 0u) << rows[6];
+}
+
+TEST(HeapProfilerTestSuite, ValuesOutliveProfilerTest) {
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    {
+        HeapProfiler heap;
+        interpreter.set_heap_profiler(&heap);
+        ASSERT_TRUE(run(interpreter, "s = \"abc\" * 10\nl = [s]\n"));
+        interpreter.set_heap_profiler(nullptr);
+    }
+    ASSERT_TRUE(run(interpreter, "s = 0\nl = 0\nprint(\"ok\")"));
+    ASSERT_EQ(output.str(), "ok");
+}
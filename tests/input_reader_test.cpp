@@ -0,0 +1,52 @@
+#include "lib/io/input_reader.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static std::vector<std::string> read_all(InputReader& reader) {
+    std::vector<std::string> lines;
+    std::string_view line;
+    while (reader.next_line(line)) lines.emplace_back(line);
+    return lines;
+}
+
+TEST(InputReaderTestSuite, SplitsLinesLikeGetline) {
+    std::istringstream input("first\n\nthird\nlast");
+    InputReader reader(input);
+
+    std::vector<std::string> expected = {"first", "", "third", "last"};
+    ASSERT_EQ(read_all(reader), expected);
+}
+
+TEST(InputReaderTestSuite, TrailingNewlineTest) {
+    std::istringstream input("a\nb\n");
+    InputReader reader(input);
+
+    std::vector<std::string> expected = {"a", "b"};
+    ASSERT_EQ(read_all(reader), expected);
+}
+
+TEST(InputReaderTestSuite, LineLongerThanBufferTest) {
+    std::string longLine(3 * 1024 * 1024, 'x');
+    std::istringstream input("head\n" + longLine + "\ntail\n");
+    InputReader reader(input);
+
+    std::vector<std::string> expected = {"head", longLine, "tail"};
+    ASSERT_EQ(read_all(reader), expected);
+}
+
+TEST(InputReaderTestSuite, MappedFileTest) {
+    std::FILE* file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    std::fputs("1 2\n3 4\n", file);
+    std::fflush(file);
+    std::rewind(file);
+
+    InputReader reader(fileno(file));
+
+    std::vector<std::string> expected = {"1 2", "3 4"};
+    ASSERT_EQ(read_all(reader), expected);
+    std::fclose(file);
+}
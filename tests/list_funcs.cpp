@@ -60,4 +60,163 @@ TEST(ListFuncsTestSuite, SortTest) {
 
     ASSERT_TRUE(interpret(input, output));
     ASSERT_EQ(output.str(), expected);
-}
\ No newline at end of file
+}
+TEST(ListFuncsTestSuite, MapFilterReduceTest) {
+    std::string code = R"(
+        square = function(x)
+            return x * x
+        end function
+        is_odd = function(x)
+            return x % 2 == 1
+        end function
+        add = function(acc, x)
+            return acc + x
+        end function
+
+        a = [1, 2, 3, 4, 5]
+        print(map(a, square))
+        print(filter(a, is_odd))
+        print(reduce(map(a, square), add, 0))
+        print(reduce(["a", "b"], add, ">"))
+    )";
+
+    std::string expected = "[1, 4, 9, 16, 25][1, 3, 5]55>ab";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+TEST(ListFuncsTestSuite, ParallelMapTest) {
+    std::string code = R"(
+        collatz = function(n)
+            steps = 0
+            while n != 1
+                if n % 2 == 0 then
+                    n = n / 2
+                else
+                    n = 3 * n + 1
+                end if
+                steps += 1
+            end while
+            return steps
+        end function
+        is_long = function(s)
+            return s > 100
+        end function
+        add = function(acc, x)
+            return acc + x
+        end function
+
+        xs = []
+        for i in range(1, 10001)
+            push(xs, i)
+        end for
+
+        steps = pmap(xs, collatz)
+        print(len(steps))
+        print(" ")
+        print(reduce(steps, add, 0))
+        print(" ")
+        print(len(filter(map(xs, collatz), is_long)))
+        print(" ")
+        print(steps[26])
+    )";
+
+    for (unsigned threads : {1u, 2u, 4u, 8u}) {
+        std::istringstream input(code);
+        std::ostringstream output;
+        Interpreter interpreter(output);
+        interpreter.set_threads(threads);
+
+        ASSERT_TRUE(interpreter.run(*Program::compile(input))) << output.str();
+        ASSERT_EQ(output.str(), "10000 849666 3748 111");
+    }
+}
+
+TEST(ListFuncsTestSuite, ImpureFunctionRunsInOrderTest) {
+    std::string code = R"(
+        offset = 100
+        shift = function(x)
+            print(x)
+            return x + offset
+        end function
+
+        print(pmap([1, 2, 3], shift))
+    )";
+
+    std::string expected = "123[101, 102, 103]";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+TEST(ListFuncsTestSuite, ParallelMapErrorTest) {
+    std::string code = R"(
+        inverse = function(x)
+            return 1 / x
+        end function
+
+        xs = []
+        for i in range(-50, 50)
+            push(xs, i)
+        end for
+        print("before")
+        ys = pmap(xs, inverse)
+        print("after")
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_FALSE(interpret(input, output));
+    ASSERT_EQ(output.str().substr(0, 13), "beforeError: ");
+}
+
+TEST(ListFuncsTestSuite, OperatorsMakeNewListsTest) {
+    std::string code = R"(
+        a = [1, 2]
+        b = a + [3]
+        c = a * 2
+        d = 0 * a
+        print(a)
+        print(b)
+        print(c)
+        print(d)
+    )";
+
+    std::string expected = "[1, 2][1, 2, 3][1, 2, 1, 2][]";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+TEST(ListFuncsTestSuite, ListFuncNamesAsVariablesTest) {
+    std::string code = R"(
+        double = function(x)
+            return 2 * x
+        end function
+        map = [1, 2]
+        filter = 3
+        reduce = 4
+        pmap = filter + reduce
+        print(map(map, double))
+        print(pmap)
+    )";
+
+    std::string expected = "[2, 4]7";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
@@ -0,0 +1,156 @@
+#include "lib/interpreter/interpreter.h"
+#include <gtest/gtest.h>
+
+TEST(MemoizeTestSuite, RecursiveFibonacciTest) {
+    std::string code = R"(
+        fib = function(n)
+            if n < 2 then
+                return n
+            end if
+            return fib(n - 1) + fib(n - 2)
+        end function
+        fib = memoize(fib)
+        println(fib(40))
+        println(memo_stats(fib))
+        println(fib(40))
+        println(memo_stats(fib))
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output)) << output.str();
+    ASSERT_EQ(output.str(), "102334155\n[38, 41, 41]\n102334155\n[39, 41, 41]\n");
+}
+
+TEST(MemoizeTestSuite, LeastRecentlyUsedEvictionTest) {
+    std::string code = R"(
+        square = function(x)
+            print(x)
+            return x * x
+        end function
+        square = memoize(square, 2)
+        square(1)
+        square(2)
+        square(1)
+        square(3)
+        square(1)
+        square(2)
+        println("")
+        println(memo_stats(square))
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output)) << output.str();
+    ASSERT_EQ(output.str(), "1232\n[2, 4, 2]\n");
+}
+
+TEST(MemoizeTestSuite, DefaultCapacityTest) {
+    std::string code = R"(
+        square = function(x)
+            return x * x
+        end function
+        square = memoize(square)
+        for i in range(0, 10, 1)
+            square(i)
+        end for
+        println(memo_stats(square))
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_memo_capacity(3);
+
+    ASSERT_TRUE(interpreter.run(*Program::compile(input))) << output.str();
+    ASSERT_EQ(output.str(), "[0, 10, 3]\n");
+}
+
+TEST(MemoizeTestSuite, KeysDistinguishTypesTest) {
+    std::string code = R"(
+        describe = memoize(function(x) return x end function)
+        println(describe(1))
+        println(describe(1.5))
+        println(describe("1"))
+        println(describe(true))
+        println(describe(nil))
+        println(describe("1"))
+        println(memo_stats(describe))
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output)) << output.str();
+    ASSERT_EQ(output.str(), "1\n1.5\n1\ntrue\nnil\n1\n[1, 5, 5]\n");
+}
+
+TEST(MemoizeTestSuite, ListArgumentsAreNotCachedTest) {
+    std::string code = R"(
+        size = memoize(function(list) return len(list) end function)
+        values = [1, 2]
+        println(size(values))
+        push(values, 3)
+        println(size(values))
+        println(memo_stats(size))
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output)) << output.str();
+    ASSERT_EQ(output.str(), "2\n3\n[0, 0, 0]\n");
+}
+
+TEST(MemoizeTestSuite, SharedAcrossParallelWorkersTest) {
+    std::string code = R"(
+        square = memoize(function(x) return x * x end function)
+        values = []
+        for i in range(0, 10000, 1)
+            push(values, i % 100)
+        end for
+        squares = pmap(values, square)
+        println(reduce(squares, function(a, b) return a + b end function, 0))
+        stats = memo_stats(square)
+        println(stats[2])
+        println(stats[0] + stats[1])
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output)) << output.str();
+    ASSERT_EQ(output.str(), "32835000\n100\n10000\n");
+}
+
+TEST(MemoizeTestSuite, InvalidArgumentsTest) {
+    for (std::string code : {
+             "memoize(1)",
+             "f = function(x) return x end function\nmemoize(f, 0)",
+             "f = function(x) return x end function\nmemo_stats(f)",
+         }) {
+        std::istringstream input(code);
+        std::ostringstream output;
+
+        ASSERT_FALSE(interpret(input, output)) << code;
+    }
+}
+
+TEST(MemoizeTestSuite, NamesAsVariablesTest) {
+    std::string code = R"(
+        square = function(x) return x * x end function
+        memoize = memoize(square)
+        f = memoize
+        f(3)
+        memo_stats = memo_stats(memoize)
+        print(memo_stats[1])
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output)) << output.str();
+    ASSERT_EQ(output.str(), "1");
+}
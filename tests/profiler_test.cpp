@@ -0,0 +1,122 @@
+#include "lib/interpreter/interpreter.h"
+#include "lib/interpreter/profiler.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+const char* kScript = R"(
+    hot = function(n)
+        total = 0
+        for i in range(0, n, 1)
+            total += i % 7
+        end for
+        return total
+    end function
+    outer = function()
+        s = 0
+        for k in range(0, 20, 1)
+            s += hot(1000)
+        end for
+        return s
+    end function
+    print(outer())
+)";
+
+}
+
+TEST(ProfilerTestSuite, CollapsedStacksTest) {
+    Profiler profiler(100);
+    std::istringstream input(kScript);
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_profiler(&profiler);
+
+    ASSERT_TRUE(interpreter.run(*Program::compile(input))) << output.str();
+    ASSERT_EQ(output.str(), "59940");
+
+    std::ostringstream collapsed;
+    profiler.write_collapsed(collapsed);
+
+    size_t total = 0;
+    size_t in_hot = 0;
+    std::istringstream lines(collapsed.str());
+    std::string stack;
+    size_t count;
+    while (lines >> stack >> count) {
+        ASSERT_EQ(stack.rfind("<script>", 0), 0u) << stack;
+        total += count;
+        if (stack == "<script>;outer;hot") in_hot = count;
+    }
+    ASSERT_EQ(total, profiler.samples());
+    // 20000 of the roughly 20040 steps are iterations inside hot().
+    ASSERT_GE(in_hot * 10, total * 9);
+}
+
+TEST(ProfilerTestSuite, FunctionTableTest) {
+    Profiler profiler(100);
+    std::istringstream input(kScript);
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_profiler(&profiler);
+
+    ASSERT_TRUE(interpreter.run(*Program::compile(input))) << output.str();
+
+    std::ostringstream table;
+    profiler.write_table(table);
+    std::istringstream lines(table.str());
+    std::string header;
+    std::getline(lines, header);
+    ASSERT_EQ(header.rfind("function", 0), 0u);
+
+    std::vector<std::string> order;
+    std::string line;
+    while (std::getline(lines, line)) {
+        order.push_back(line.substr(0, line.find(' ')));
+    }
+    ASSERT_EQ(order, (std::vector<std::string>{"<script>", "outer", "hot"}));
+}
+
+TEST(ProfilerTestSuite, LineTableTest) {
+    Profiler profiler(100);
+    std::istringstream input(kScript);
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_profiler(&profiler);
+
+    ASSERT_TRUE(interpreter.run(*Program::compile(input))) << output.str();
+
+    std::ostringstream table;
+    profiler.write_lines(table);
+    std::istringstream rows(table.str());
+    std::string header;
+    std::getline(rows, header);
+    ASSERT_EQ(header.substr(0, 20), "  line  function    ");
+
+    std::vector<std::pair<uint32_t, std::string>> order;
+    size_t total = 0;
+    uint32_t line;
+    std::string function;
+    double ms, percent;
+    size_t samples;
+    while (rows >> line >> function >> ms >> percent >> samples) {
+        order.emplace_back(line, function);
+        total += samples;
+    }
+    ASSERT_EQ(total, profiler.samples());
+    // Samples are taken at loop iterations and calls, so the loop in hot()
+    // gets nearly all of them.
+    ASSERT_FALSE(order.empty());
+    ASSERT_EQ(order.front(), std::make_pair(uint32_t(4), std::string("hot")));
+}
+
+TEST(ProfilerTestSuite, DisabledByDefaultTest) {
+    Profiler profiler(1);
+    std::istringstream input(kScript);
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_profiler(&profiler);
+    interpreter.set_profiler(nullptr);
+
+    ASSERT_TRUE(interpreter.run(*Program::compile(input)));
+    ASSERT_EQ(profiler.samples(), 0u);
+}
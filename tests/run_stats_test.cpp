@@ -0,0 +1,126 @@
+#include "lib/interpreter/interpreter.h"
+#include "lib/interpreter/run_stats.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+bool run(Interpreter& interpreter, const std::string& code) {
+    std::istringstream input(code);
+    return interpreter.run(*Program::compile(input));
+}
+
+}
+
+TEST(RunStatsTestSuite, CountsTest) {
+    std::string code = R"(
+        add = function(a, b)
+            return a + b
+        end function
+        words = []
+        for i in range(0, 10, 1)
+            if i == 8 then
+                break
+            end if
+            words = words + [to_string(add(i, 1)) + "!"]
+        end for
+    )";
+
+    RunStats stats;
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_stats(&stats);
+    ASSERT_TRUE(run(interpreter, code)) << output.str();
+
+    ASSERT_EQ(stats.get(RunStats::Calls), 8u);
+    ASSERT_EQ(stats.get(RunStats::Exceptions), 1u);
+    // The empty list, then [..] and the concatenation on each of the 8
+    // iterations; a for loop over range() does not build the list.
+    ASSERT_EQ(stats.get(RunStats::ListAllocations), 17u);
+    // to_string() and the concatenation on each iteration.
+    ASSERT_EQ(stats.get(RunStats::StringAllocations), 16u);
+    // i in 9 checks, then words, add, i, a, b on 8 iterations.
+    ASSERT_EQ(stats.get(RunStats::Lookups), 9u + 8u * 5u);
+}
+
+TEST(RunStatsTestSuite, StatsBuiltinTest) {
+    std::string code = R"(
+        f = function(x)
+            return x
+        end function
+        f(1)
+        f(2)
+        s = run_stats()
+        print(s[3])
+    )";
+
+    RunStats stats;
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_stats(&stats);
+    ASSERT_TRUE(run(interpreter, code)) << output.str();
+    ASSERT_EQ(output.str(), "2");
+}
+
+TEST(RunStatsTestSuite, TailCallsCountedTest) {
+    std::string code = R"(
+        count_down = function(n)
+            if n == 0 then
+                return 0
+            end if
+            return count_down(n - 1)
+        end function
+        count_down(1000)
+    )";
+
+    RunStats stats;
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_stats(&stats);
+    ASSERT_TRUE(run(interpreter, code)) << output.str();
+    // The first call, then one tail call per level.
+    ASSERT_EQ(stats.get(RunStats::Calls), 1001u);
+}
+
+TEST(RunStatsTestSuite, LargeCountersTest) {
+    RunStats stats;
+    stats.add(RunStats::Lookups, uint64_t(3) << 30);
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_stats(&stats);
+    ASSERT_TRUE(run(interpreter, "s = run_stats()\nprint(s[0] > 3000000000.0)")) << output.str();
+    ASSERT_EQ(output.str(), "true");
+}
+
+TEST(RunStatsTestSuite, WriteTest) {
+    RunStats stats;
+    stats.add(RunStats::Calls, 3);
+    stats.add(RunStats::Lookups);
+
+    std::ostringstream report;
+    stats.write(report);
+    ASSERT_EQ(report.str(),
+        "lookups 1\n"
+        "string_allocations 0\n"
+        "list_allocations 0\n"
+        "calls 3\n"
+        "exceptions 0\n");
+
+    stats.reset();
+    ASSERT_EQ(stats.get(RunStats::Calls), 0u);
+}
+
+TEST(RunStatsTestSuite, NameAsVariableTest) {
+    RunStats stats;
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_stats(&stats);
+    ASSERT_TRUE(run(interpreter, "run_stats = run_stats()\nprint(len(run_stats))")) << output.str();
+    ASSERT_EQ(output.str(), "5");
+}
+
+TEST(RunStatsTestSuite, DisabledByDefaultTest) {
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    ASSERT_FALSE(run(interpreter, "s = run_stats()"));
+    ASSERT_EQ(output.str(), "Error: run_stats() needs run statistics to be enabled (line 1)\n");
+}
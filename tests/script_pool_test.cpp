@@ -0,0 +1,61 @@
+#include "lib/interpreter/script_pool.h"
+#include <gtest/gtest.h>
+
+TEST(ScriptPoolTestSuite, BatchTest) {
+    std::string code = R"(
+        fib = function(n)
+            if n < 2 then
+                return n
+            end if
+            return fib(n - 1) + fib(n - 2)
+        end function
+
+        n = parse_num(read())
+        println(fib(n))
+    )";
+
+    std::vector<ScriptJob> jobs;
+    for (int i = 0; i < 40; ++i) {
+        jobs.push_back({code, std::to_string(i % 15) + "\n"});
+    }
+
+    ScriptPool pool(4);
+    auto results = pool.run(jobs);
+
+    int expected[15] = {0, 1, 1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 144, 233, 377};
+    ASSERT_EQ(results.size(), jobs.size());
+    for (int i = 0; i < 40; ++i) {
+        ASSERT_TRUE(results[i].ok) << results[i].output;
+        ASSERT_EQ(results[i].output, std::to_string(expected[i % 15]) + "\n");
+    }
+}
+
+TEST(ScriptPoolTestSuite, JobsDoNotShareStateTest) {
+    std::string code = R"(
+        s = "ab"
+        s += read()
+        print(s)
+    )";
+
+    ScriptPool pool(2);
+    auto results = pool.run({{code, "x"}, {code, "y"}, {code, "z"}, {code, "w"}});
+
+    ASSERT_EQ(results[0].output, "abx");
+    ASSERT_EQ(results[1].output, "aby");
+    ASSERT_EQ(results[2].output, "abz");
+    ASSERT_EQ(results[3].output, "abw");
+}
+
+TEST(ScriptPoolTestSuite, ErrorIsReportedPerJobTest) {
+    std::string good = "print(1 + 1)\n";
+    std::string bad = "print(1)\nprint(1 / 0)\nprint(3)\n";
+
+    ScriptPool pool(2);
+    auto results = pool.run({{good, ""}, {bad, ""}, {good, ""}});
+
+    ASSERT_TRUE(results[0].ok);
+    ASSERT_EQ(results[0].output, "2");
+    ASSERT_FALSE(results[1].ok);
+    ASSERT_EQ(results[1].output.substr(0, 8), "1Error: ");
+    ASSERT_TRUE(results[2].ok);
+}
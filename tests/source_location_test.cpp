@@ -0,0 +1,96 @@
+#include "lib/interpreter/interpreter.h"
+#include "lib/lexer/lexer.h"
+#include <gtest/gtest.h>
+
+static std::string run(const std::string& code) {
+    std::istringstream input(code);
+    std::ostringstream output;
+    interpret(input, output);
+    return output.str();
+}
+
+TEST(SourceLocationTestSuite, TokenPositionsTest) {
+    Lexer lexer("x = 1 // note\n\n  print(\"a\nb\")\ny", 10);
+
+    std::vector<std::tuple<TokenType, uint32_t, uint32_t>> expected = {
+        {TokenType::VAR, 10, 1},
+        {TokenType::EQUAL, 10, 3},
+        {TokenType::INTEGER, 10, 5},
+        {TokenType::PRINT, 12, 3},
+        {TokenType::LPAREN, 12, 8},
+        {TokenType::STRING, 12, 9},
+        {TokenType::RPAREN, 13, 3},
+        {TokenType::VAR, 14, 1},
+        {TokenType::END, 14, 2},
+    };
+    for (auto& [type, line, column] : expected) {
+        Token token = lexer.get_next_token();
+        ASSERT_EQ(token.type, type) << token.value;
+        ASSERT_EQ(token.line, line) << token.value;
+        ASSERT_EQ(token.column, column) << token.value;
+    }
+}
+
+TEST(SourceLocationTestSuite, RuntimeErrorInFunctionTest) {
+    std::string code = R"(
+        items = [1, 2, 3]
+
+        // Reads one past the end.
+        last = function(list)
+            n = len(list)
+
+            return list[n]
+        end function
+        print(last(items))
+    )";
+
+    ASSERT_EQ(run(code), "Error: List index out of range (line 8)\n");
+}
+
+TEST(SourceLocationTestSuite, ErrorInsideNestedBlocksTest) {
+    std::string code = R"(
+        for i in range(0, 3, 1)
+            if i == 2 then
+                print(i / "x")
+            end if
+            print(i)
+        end for
+    )";
+
+    std::string output = run(code);
+    ASSERT_EQ(output.substr(0, 9), "01Error: ");
+    ASSERT_EQ(output.substr(output.size() - 10), " (line 4)\n");
+}
+
+TEST(SourceLocationTestSuite, SyntaxErrorInBlockTest) {
+    std::string code = R"(
+        print("ok")
+        f = function(x)
+            y = (x + 1
+            return y
+        end function
+    )";
+
+    std::string output = run(code);
+    ASSERT_EQ(output.substr(0, 9), "okError: ");
+    ASSERT_EQ(output.substr(output.size() - 10), " (line 4)\n");
+}
+
+TEST(SourceLocationTestSuite, ErrorInParallelWorkerTest) {
+    std::string code = R"(
+        check = function(x)
+            if x == 4000 then
+                return x / "boom"
+            end if
+            return x
+        end function
+        xs = []
+        for i in range(0, 8192, 1)
+            push(xs, i)
+        end for
+        ys = pmap(xs, check)
+    )";
+
+    std::string output = run(code);
+    ASSERT_EQ(output.substr(output.size() - 10), " (line 4)\n");
+}
@@ -24,4 +24,27 @@ TEST(StacktraceTestSuite, StacktraceTest) {
 
     ASSERT_TRUE(interpret(input, output));
     ASSERT_EQ(output.str(), expected);
-}
\ No newline at end of file
+}
+TEST(StacktraceTestSuite, FramesNamedByDefinitionTest) {
+    std::string code = R"(
+        foo = function()
+            println(stacktrace())
+        end function
+
+        alias = foo
+        alias()
+        apply = function(f)
+            f()
+        end function
+        apply(function() println(stacktrace()) end function)
+        println(map([1], function(x) return len(stacktrace()) end function))
+    )";
+
+    std::string expected = "[foo]\n[apply, <anon>]\n[1]\n";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
@@ -115,3 +115,125 @@ TEST(StringFuncsTestSuite, SliceTest) {
     ASSERT_EQ(output.str(), expected);
 }
 
+
+TEST(StringFuncsTestSuite, ReplaceLongLineTest) {
+    std::string code = R"(
+        a = "GET /index.html 200 " * 1000
+        b = replace(a, "200", "404")
+        print(len(b))
+        print(b[16 : 19])
+    )";
+
+    std::string expected = "20000404";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+TEST(StringFuncsTestSuite, SplitEmptyDelimiterTest) {
+    std::string code = R"(
+        b = split("abc", "")
+        print(239)
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_FALSE(interpret(input, output));
+    ASSERT_FALSE(output.str().ends_with("239"));
+}
+
+TEST(StringFuncsTestSuite, CharacterClassFuncsTest) {
+    std::string code = R"(
+        println(is_digit("2025"))
+        println(is_digit("20x5"))
+        println(is_alpha("itmo"))
+        println("[" + trim("  padded \t") + "]")
+        println(count("a,b,,c", ","))
+    )";
+
+    std::string expected = "true\nfalse\ntrue\n[padded]\n3\n";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+TEST(StringFuncsTestSuite, JoinNumbersTest) {
+    std::string code = R"(
+        a = [1.5, -20, nil, 0.1]
+        println(join(a, ";"))
+        println(join([], ";"))
+        println(join([1, 2, 3, 4, 5, 6, 7, 8, 9, 10], ","))
+    )";
+
+    std::string expected = "1.500000;-20;;0.100000\n\n1,2,3,4,5,6,7,8,9,10\n";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+TEST(StringFuncsTestSuite, Utf8CaseTest) {
+    std::string code = R"(
+        println(upper("Привет, мир"))
+        println(lower("ÉCOLE"))
+    )";
+
+    std::string expected = "ПРИВЕТ, МИР\nécole\n";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+TEST(StringFuncsTestSuite, TextFuncNamesAsVariablesTest) {
+    std::string code = R"(
+        count = 0
+        trim = " x "
+        is_digit = true
+        is_alpha = false
+        for c in split("a,b,c", ",")
+            count += 1
+        end for
+        println(count)
+        println(count(trim, "x"))
+        println(is_digit or is_alpha)
+    )";
+
+    std::string expected = "3\n1\ntrue\n";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+TEST(StringFuncsTestSuite, StringEqualityComparesContentsTest) {
+    std::string code = R"(
+        a = "a"
+        computed = lower("A")
+        println(a == computed)
+        println(computed != "a")
+        println("a" + "b" == "ab")
+        println("a" == "b")
+    )";
+
+    std::string expected = "true\nfalse\ntrue\nfalse\n";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
@@ -0,0 +1,117 @@
+#include "lib/interpreter/interpreter.h"
+#include <gtest/gtest.h>
+
+TEST(TailCallTestSuite, TenMillionSelfCallsTest) {
+    std::string code = R"(
+        tally = function(n, acc)
+            if n == 0 then
+                return acc
+            end if
+            return tally(n - 1, acc + 1)
+        end function
+        print(tally(10000000, 0))
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output)) << output.str();
+    ASSERT_EQ(output.str(), "10000000");
+}
+
+TEST(TailCallTestSuite, TenMillionMutualCallsTest) {
+    std::string code = R"(
+        is_even = function(n)
+            if n == 0 then
+                return true
+            end if
+            return is_odd(n - 1)
+        end function
+        is_odd = function(n)
+            if n == 0 then
+                return false
+            end if
+            return is_even(n - 1)
+        end function
+        print(is_even(10000000))
+        print(" ")
+        print(is_odd(7))
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output)) << output.str();
+    ASSERT_EQ(output.str(), "true true");
+}
+
+TEST(TailCallTestSuite, StacktraceKeepsRecentTailCallsTest) {
+    std::string code = R"(
+        down = function(n)
+            if n == 0 then
+                return stacktrace()
+            end if
+            return down(n - 1)
+        end function
+        outer = function()
+            trace = down(3)
+            print(trace)
+            print(" ")
+            print(len(down(100)))
+        end function
+        outer()
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output)) << output.str();
+    ASSERT_EQ(output.str(), "[outer, down, down, down, down] 17");
+}
+
+TEST(TailCallTestSuite, ReturnFromNestedBlocksTest) {
+    std::string code = R"(
+        find = function(xs, x)
+            i = 0
+            for v in xs
+                while true
+                    if v == x then
+                        return i
+                    end if
+                    break
+                end while
+                i += 1
+            end for
+            return -1
+        end function
+        print(find([5, 6, 7], 6))
+        print(find([5, 6, 7], 8))
+        return 0
+        print("unreachable")
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output)) << output.str();
+    ASSERT_EQ(output.str(), "1-1");
+}
+
+TEST(TailCallTestSuite, CalleeSeesCallerLocalsTest) {
+    std::string code = R"(
+        outer = function(x)
+            y = 10
+            inner = function(z)
+                return z + y
+            end function
+            return inner(x)
+        end function
+        print(outer(5))
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output)) << output.str();
+    ASSERT_EQ(output.str(), "15");
+}
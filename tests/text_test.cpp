@@ -0,0 +1,82 @@
+#include "lib/text/text.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+TEST(TextTestSuite, FindMatchesStdFind) {
+    std::mt19937 gen(239);
+    std::uniform_int_distribution<int> letter('a', 'c');
+
+    for (int round = 0; round < 2000; ++round) {
+        std::string haystack(gen() % 100, ' ');
+        for (auto& c : haystack) c = letter(gen);
+        std::string needle(1 + gen() % 5, ' ');
+        for (auto& c : needle) c = letter(gen);
+        size_t from = gen() % (haystack.size() + 2);
+
+        ASSERT_EQ(find_substring(haystack, needle, from), haystack.find(needle, from))
+            << haystack << " / " << needle << " / " << from;
+    }
+}
+
+TEST(TextTestSuite, FindInLongLine) {
+    std::string line(100000, 'x');
+    line += "ERROR code=42";
+
+    ASSERT_EQ(find_substring(line, "ERROR"), 100000);
+    ASSERT_EQ(find_substring(line, "code=42"), 100006);
+    ASSERT_EQ(find_substring(line, "code=43"), std::string::npos);
+}
+
+TEST(TextTestSuite, SplitViewsTest) {
+    std::vector<std::string_view> expected = {"", "a", "", "b", ""};
+    ASSERT_EQ(split_views(",a,,b,", ","), expected);
+
+    expected = {"no delimiter"};
+    ASSERT_EQ(split_views("no delimiter", "::"), expected);
+}
+
+TEST(TextTestSuite, ReplaceAllTest) {
+    ASSERT_EQ(replace_all("aaaa", "aa", "b"), "bb");
+    ASSERT_EQ(replace_all("abcabc", "b", ""), "acac");
+    ASSERT_EQ(replace_all("abc", "x", "yyy"), "abc");
+    ASSERT_EQ(replace_all("x", "x", "longer"), "longer");
+    ASSERT_EQ(replace_all("a-b-c-d-e-f-g-h-i", "-", "+"), "a+b+c+d+e+f+g+h+i");
+}
+
+TEST(TextTestSuite, CaseConversionTest) {
+    std::string text = "Hello, WORLD! Привет 123 mixed CASE text over sixteen bytes";
+
+    ASSERT_EQ(lower_case(text), "hello, world! привет 123 mixed case text over sixteen bytes");
+    ASSERT_EQ(upper_case(text), "HELLO, WORLD! ПРИВЕТ 123 MIXED CASE TEXT OVER SIXTEEN BYTES");
+    ASSERT_EQ(lower_case("@[`{"), "@[`{");
+    ASSERT_EQ(upper_case("twenty chars of text"), "TWENTY CHARS OF TEXT");
+}
+
+TEST(TextTestSuite, Utf8CaseConversionTest) {
+    ASSERT_EQ(upper_case("ёжик в тумане, Ελληνικά ς, Çà et là, łódź, ÿ"), "ЁЖИК В ТУМАНЕ, ΕΛΛΗΝΙΚΆ Σ, ÇÀ ET LÀ, ŁÓDŹ, Ÿ");
+    ASSERT_EQ(lower_case("ЁЖИК В ТУМАНЕ, ΕΛΛΗΝΙΚΆ, ÇÀ ET LÀ, ŁÓDŹ, Ÿ"), "ёжик в тумане, ελληνικά, çà et là, łódź, ÿ");
+    // Signs, characters outside the mapped blocks and broken sequences are
+    // kept as they are.
+    ASSERT_EQ(upper_case("× ÷ € 日本 ß İ ı"), "× ÷ € 日本 ß İ ı");
+    ASSERT_EQ(upper_case("a\xD0"), "A\xD0");
+    ASSERT_EQ(lower_case("\xD0" "A\x80"), "\xD0" "a\x80");
+}
+
+TEST(TextTestSuite, CharacterClassTest) {
+    ASSERT_TRUE(all_digits("01234567890123456789"));
+    ASSERT_FALSE(all_digits("0123456789012345678a"));
+    ASSERT_FALSE(all_digits(""));
+    ASSERT_TRUE(all_alpha("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"));
+    ASSERT_FALSE(all_alpha("abcdefghijklmnop_"));
+    ASSERT_FALSE(all_alpha("ab1"));
+}
+
+TEST(TextTestSuite, CountTest) {
+    std::string text(1000, 'a');
+    text += "b";
+
+    ASSERT_EQ(count_substring(text, "a"), 1000);
+    ASSERT_EQ(count_substring(text, "aa"), 500);
+    ASSERT_EQ(count_substring(text, "ab"), 1);
+}
@@ -0,0 +1,131 @@
+#include "lib/interpreter/interpreter.h"
+#include "lib/interpreter/tracer.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+struct Event {
+    std::string name;
+    double ts = 0;
+    double dur = 0;
+};
+
+// Complete events of the trace, one per line as write_json puts them.
+std::vector<Event> parse_events(const std::string& json) {
+    std::vector<Event> events;
+    std::istringstream lines(json);
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (line.find("\"ph\": \"X\"") == std::string::npos) continue;
+        Event event;
+        size_t name = line.find("\"name\": \"") + 9;
+        event.name = line.substr(name, line.find('"', name) - name);
+        event.ts = std::stod(line.substr(line.find("\"ts\": ") + 6));
+        event.dur = std::stod(line.substr(line.find("\"dur\": ") + 7));
+        events.push_back(event);
+    }
+    return events;
+}
+
+size_t count_named(const std::vector<Event>& events, const std::string& name) {
+    return std::count_if(events.begin(), events.end(), [&](const Event& e) { return e.name == name; });
+}
+
+bool run(Interpreter& interpreter, const std::string& code) {
+    std::istringstream input(code);
+    return interpreter.run(*Program::compile(input));
+}
+
+}
+
+TEST(TracerTestSuite, FunctionsAndBuiltinsTest) {
+    std::string code = R"(
+        sorted_words = function(text)
+            words = split(text, " ")
+            sort(words)
+            return words
+        end function
+        for i in range(0, 3, 1)
+            println(len(join(sorted_words("c a b"), ",")))
+        end for
+    )";
+
+    Tracer tracer;
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_tracer(&tracer);
+    ASSERT_TRUE(run(interpreter, code)) << output.str();
+    ASSERT_EQ(output.str(), "5\n5\n5\n");
+
+    std::ostringstream json;
+    tracer.write_json(json);
+    ASSERT_EQ(json.str().rfind("{\"traceEvents\": [", 0), 0u);
+
+    std::vector<Event> events = parse_events(json.str());
+    ASSERT_EQ(count_named(events, "sorted_words"), 3u);
+    ASSERT_EQ(count_named(events, "split"), 3u);
+    ASSERT_EQ(count_named(events, "sort"), 3u);
+    ASSERT_EQ(count_named(events, "join"), 3u);
+    ASSERT_EQ(count_named(events, "println"), 3u);
+    ASSERT_EQ(events.size(), 15u);
+    ASSERT_EQ(tracer.events(), 15u);
+
+    // Builtins called from the function lie within its event.
+    for (auto& fn : events) {
+        if (fn.name != "sorted_words") continue;
+        size_t inside = 0;
+        for (auto& other : events) {
+            if (other.name == "sort" && other.ts >= fn.ts && other.ts + other.dur <= fn.ts + fn.dur) ++inside;
+        }
+        ASSERT_EQ(inside, 1u);
+    }
+}
+
+TEST(TracerTestSuite, TailCallsAreSeparateEventsTest) {
+    std::string code = R"(
+        count_down = function(n)
+            if n == 0 then
+                return 0
+            end if
+            return count_down(n - 1)
+        end function
+        count_down(4)
+    )";
+
+    Tracer tracer;
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_tracer(&tracer);
+    ASSERT_TRUE(run(interpreter, code)) << output.str();
+
+    std::ostringstream json;
+    tracer.write_json(json);
+    ASSERT_EQ(count_named(parse_events(json.str()), "count_down"), 5u);
+}
+
+TEST(TracerTestSuite, RingBufferKeepsNewestTest) {
+    std::string code = R"(
+        for i in range(0, 20, 1)
+            print(i)
+        end for
+    )";
+
+    Tracer tracer(8);
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_tracer(&tracer);
+    ASSERT_TRUE(run(interpreter, code)) << output.str();
+
+    ASSERT_EQ(tracer.events(), 8u);
+    ASSERT_EQ(tracer.dropped(), 12u);
+}
+
+TEST(TracerTestSuite, DisabledByDefaultTest) {
+    Tracer tracer;
+    std::ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.set_tracer(&tracer);
+    interpreter.set_tracer(nullptr);
+    ASSERT_TRUE(run(interpreter, "print(1)"));
+    ASSERT_EQ(tracer.events(), 0u);
+}